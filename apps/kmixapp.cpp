@@ -26,6 +26,8 @@
 
 #include "kmix_debug.h"
 #include "core/ControlManager.h"
+#include "core/backendrecorder.h"
+#include "backends/mixer_replay.h"
 #include "apps/kmixwindow.h"
 #include "settings.h"
 
@@ -55,6 +57,7 @@ KMixApp::KMixApp()
 KMixApp::~KMixApp()
 {
 	qCDebug(KMIX_LOG) << "Deleting KMixApp";
+	BackendRecorder::stop();
 	ControlManager::instance().shutdownNow();
 	delete m_kmix;
 	m_kmix = nullptr;
@@ -222,4 +225,12 @@ void KMixApp::parseOptions(const QCommandLineParser &parser)
 {
 	m_hasArgKeepvisibility = parser.isSet("keepvisibility");
 	m_hasArgReset = parser.isSet("failsafe");
+
+	if (parser.isSet("record")) BackendRecorder::start(parser.value("record"));
+	if (parser.isSet("replay"))
+	{
+		double speed = 1.0;
+		if (parser.isSet("replay-speed")) speed = qMax(parser.value("replay-speed").toDouble(), 0.0);
+		BackendReplay::load(parser.value("replay"), speed);
+	}
 }
@@ -20,17 +20,41 @@
 
 #include <qcoreapplication.h>
 #include <qcommandlineparser.h>
+#include <qthread.h>
+#include <qdbusargument.h>
+#include <qdbusconnection.h>
+#include <qdbusmessage.h>
+#include <qfileinfo.h>
+#include <qtextstream.h>
 
 #include <kaboutdata.h>
 #include <klocalizedstring.h>
 #include <kconfig.h>
 
-#include "gui/kmixtoolbox.h"
 #include "core/mixer.h"
 #include "core/mixertoolbox.h"
+#include "core/volumesnapshot.h"
 #include "settings.h"
 
 
+/**
+ * Call a method of the Stats interface of the running KMix, reporting
+ * an error if that fails.
+ */
+static QDBusMessage callStats(const QString &method, const QVariantList &args = QVariantList())
+{
+   QDBusMessage call = QDBusMessage::createMethodCall("org.kde.kmix", "/Stats", "org.kde.KMix.Stats", method);
+   call.setArguments(args);
+
+   const QDBusMessage reply = QDBusConnection::sessionBus().call(call);
+   if (reply.type()==QDBusMessage::ErrorMessage)
+   {
+      QTextStream(stderr) << i18n("Cannot contact KMix: %1", reply.errorMessage()) << endl;
+   }
+   return (reply);
+}
+
+
 int main(int argc, char *argv[])
 {
     QCoreApplication app(argc, argv);
@@ -51,28 +75,108 @@ int main(int argc, char *argv[])
                                        i18n("Save current volumes as default")));
    parser.addOption(QCommandLineOption((QStringList() << "r" << "restore"),
                                        i18n("Restore default volumes")));
+   parser.addOption(QCommandLineOption((QStringList() << "p" << "parallel"),
+                                       i18n("Restore the volumes of several sound cards at the same time")));
+   parser.addOption(QCommandLineOption(QStringList() << "stats",
+                                       i18n("Show the performance counters of the running KMix")));
+   parser.addOption(QCommandLineOption(QStringList() << "trace-start",
+                                       i18n("Start tracing the handling of changes in the running KMix")));
+   parser.addOption(QCommandLineOption(QStringList() << "trace-stop",
+                                       i18n("Stop tracing, and write the trace to a file in Chrome trace format"),
+                                       i18n("file")));
    parser.process(app);
 
+   // Only the running application has anything to show
+   if (parser.isSet("stats"))
+   {
+      const QDBusMessage reply = callStats("values");
+      if (reply.type()==QDBusMessage::ErrorMessage) return 1;
+
+      QTextStream out(stdout);
+      const QVariantMap values = qdbus_cast<QVariantMap>(reply.arguments().value(0));
+      for (QVariantMap::const_iterator it = values.constBegin(); it!=values.constEnd(); ++it)
+      {
+         out << it.key() << ' ' << it.value().toString() << endl;
+      }
+      return 0;
+   }
+
+   if (parser.isSet("trace-start"))
+   {
+      return (callStats("startTrace").type()==QDBusMessage::ErrorMessage ? 1 : 0);
+   }
+
+   if (parser.isSet("trace-stop"))
+   {
+      // KMix writes the file, so it needs the full path
+      const QString fileName = QFileInfo(parser.value("trace-stop")).absoluteFilePath();
+      const QDBusMessage reply = callStats("stopTrace", QVariantList() << fileName);
+      if (reply.type()==QDBusMessage::ErrorMessage) return 1;
+      if (!reply.arguments().value(0).toBool())
+      {
+         QTextStream(stderr) << i18n("KMix cannot write the trace to %1", fileName) << endl;
+         return 1;
+      }
+      return 0;
+   }
+
+   // Nothing else needs to see the mixers
+   Mixer::setPublishing(false);
+
+   const KConfig *config = Settings::self()->config();
+   VolumeSnapshot snapshot(config->name());
+   const bool haveSnapshot = snapshot.open();
+
    // create mixers
-   MixerToolBox::initMixer(false, QStringList(), false);
+   if (parser.isSet("restore") && !parser.isSet("save") && haveSnapshot)
+   {
+      // Only open the cards that there are saved volumes for
+      if (!MixerToolBox::initMixerFromSnapshot(snapshot))
+      {
+         MixerToolBox::deinitMixer();
+         MixerToolBox::initMixer(false, QStringList(), false);
+      }
+   }
+   else MixerToolBox::initMixer(false, QStringList(), false);
 
    // load volumes
    if ( parser.isSet("restore") )
    {
+      QList<QThread *> threads;
       for (int i=0; i<Mixer::mixers().count(); ++i) {
          Mixer *mixer = (Mixer::mixers())[i];
-         mixer->volumeLoad(Settings::self()->config());
+         if (parser.isSet("parallel") && haveSnapshot && snapshot.hasMixer(mixer->id()))
+         {
+            // Restoring from the snapshot does not touch the config,
+            // and nothing is listening, so the cards are independent.
+            //
+            // The backend I/O runs in this thread, but the mixer, its
+            // backend and its controls still belong to the main thread.
+            // That is only safe because kmixctrl never runs an event loop
+            // and the main thread just waits below, so no timer, posted
+            // event or queued signal can reach these objects meanwhile.
+            // Only static (snapshot) mixers get here, which have no
+            // mainloop of their own, and volumeLoad(config, false) neither
+            // reads back nor announces.  Nothing that relies on the
+            // thread affinity of these objects may be used from here.
+            QThread *thread = QThread::create([mixer, config]() { mixer->volumeLoad(config, false); });
+            thread->start();
+            threads.append(thread);
+         }
+         else mixer->volumeLoad(config);
+      }
+
+      for (QThread *thread : qAsConst(threads))
+      {
+         thread->wait();
+         delete thread;
       }
    }
 
    // save volumes
 	if (parser.isSet("save"))
 	{
-		for (int i = 0; i < Mixer::mixers().count(); ++i)
-		{
-			const Mixer *mixer = (Mixer::mixers())[i];
-			mixer->volumeSave(Settings::self()->config());
-		}
+		Mixer::volumeSaveAll(Settings::self()->config(), Mixer::mixers());
 	}
 
    MixerToolBox::deinitMixer();
@@ -29,8 +29,11 @@
 
 // KMix
 #include "core/mixertoolbox.h"
+#include "core/controleventserver.h"
 #include "core/kmixdevicemanager.h"
 #include "core/mixer.h"
+#include "core/mixerstateexport.h"
+#include "core/startupsequence.h"
 #include "settings.h"
 
 
@@ -44,33 +47,36 @@ K_PLUGIN_FACTORY_WITH_JSON(KMixDFactory,
  */
 KMixD::KMixD(QObject* parent, const QList<QVariant>&) :
    KDEDModule(parent),
-   m_multiDriverMode (false) // -<- I never-ever want the multi-drivermode to be activated by accident
+   m_multiDriverMode (false), // -<- I never-ever want the multi-drivermode to be activated by accident
+   m_startup(new StartupSequence(QStringLiteral("kmixd"), this))
 {
     setObjectName( QStringLiteral("KMixD" ));
-	qCDebug(KMIX_LOG) << "kmixd: Triggering delayed initialization";
-	QTimer::singleShot( 3000, this, SLOT(delayedInitialization()));
-}
-
-/**
- * This is called by a singleShot timer. Reason is that KMixD seems to "collide" with other applications
- * on DBUS, likely creating deadlocks. See Bug 317926 for that. By artificially delaying initialization,
- * KMixD gets hopefully out of the way of the other applications, avoiding these deadlocks. A small delay
- * should also not harm too much, as apps using the Mixer DBUS calls on KMixD must be prepared that the
- * interface is not available right when they start.
- */
-void KMixD::delayedInitialization()
-{
-    qCDebug(KMIX_LOG) << "Delayed initialization running now";
-   //initActions(); // init actions first, so we can use them in the loadConfig() already
-   loadConfig(); // Load config before initMixer(), e.g. due to "MultiDriver" keyword
-   MixerToolBox::initMixer(m_multiDriverMode, m_backendFilter, true);
-
-   KMixDeviceManager *theKMixDeviceManager = KMixDeviceManager::instance();
-   connect(theKMixDeviceManager, &KMixDeviceManager::plugged, this, &KMixD::plugged);
-   connect(theKMixDeviceManager, &KMixDeviceManager::unplugged, this, &KMixD::unplugged);
-   theKMixDeviceManager->initHotplug();
 
-   qCDebug(KMIX_LOG) << "Delayed initialization done";
+    // All stages run from the event loop, so none of them run while kded is
+    // still loading its modules.  KMixD used to wait for a fixed time before
+    // initializing, to keep out of the way of other applications on D-Bus
+    // (see Bug 317926).  If that is still needed, DaemonStartDelay can be set.
+    m_startup->addStage(QStringLiteral("config"), QStringList(), [this]()
+    {
+        loadConfig(); // Load config before initMixer(), e.g. due to "MultiDriver" keyword
+    });
+    m_startup->addStage(QStringLiteral("mixers"), { QStringLiteral("config") }, [this]()
+    {
+        MixerStateExport::setInstanceName(QStringLiteral("kmixd"));
+        MixerToolBox::initMixer(m_multiDriverMode, m_backendFilter, true);
+    });
+    m_startup->addStage(QStringLiteral("events"), { QStringLiteral("mixers") }, [this]()
+    {
+        ControlEventServer::initialize(this, QStringLiteral("kmixd-events"));
+    });
+    m_startup->addStage(QStringLiteral("hotplug"), { QStringLiteral("mixers") }, [this]()
+    {
+        KMixDeviceManager *theKMixDeviceManager = KMixDeviceManager::instance();
+        connect(theKMixDeviceManager, &KMixDeviceManager::plugged, this, &KMixD::plugged);
+        connect(theKMixDeviceManager, &KMixDeviceManager::unplugged, this, &KMixD::unplugged);
+        theKMixDeviceManager->initHotplug();
+    });
+    m_startup->start(Settings::daemonStartDelay());
 }
 
 
@@ -32,6 +32,8 @@
 // KDE
 #include <kdedmodule.h> 
 
+class StartupSequence;
+
 class
 KMixD : public KDEDModule, protected QDBusContext
 {
@@ -52,9 +54,9 @@ KMixD : public KDEDModule, protected QDBusContext
   private:
    bool m_multiDriverMode;
    QList<QString> m_backendFilter;
+   StartupSequence *m_startup;
 
   private slots:
-   void delayedInitialization();
    void saveConfig();
 
    void plugged(const char *driverName, const QString &udi, int dev);
@@ -42,8 +42,14 @@
 // KMix
 #include "kmix_debug.h"
 #include "core/ControlManager.h"
+#include "core/controleventserver.h"
 #include "core/mixertoolbox.h"
 #include "core/kmixdevicemanager.h"
+#include "core/kmixtrace.h"
+#include "core/mixerstateexport.h"
+#include "core/startupsequence.h"
+#include "core/topologycache.h"
+#include "backends/mixer_replay.h"
 #include "gui/kmixerwidget.h"
 #include "gui/kmixprefdlg.h"
 #include "gui/kmixdockwidget.h"
@@ -51,6 +57,7 @@
 #include "gui/dialogaddview.h"
 #include "gui/dialogselectmaster.h"
 #include "dbus/dbusmixsetwrapper.h"
+#include "dbus/dbusstatswrapper.h"
 #include "settings.h"
 
 #ifdef HAVE_CANBERRA
@@ -80,26 +87,8 @@ KMixWindow::KMixWindow(bool invisible, bool reset) :
 	initWidgets();
 	initPrefDlg();
 	DBusMixSetWrapper::initialize(this, QStringLiteral("/Mixers"));
-	MixerToolBox::initMixer(m_multiDriverMode, m_backendFilter, true);
-	KMixDeviceManager *theKMixDeviceManager = KMixDeviceManager::instance();
-	initActionsAfterInitMixer(); // init actions that require initialized mixer backend(s).
-
-	recreateGUI(false, reset);
-	if (m_wsMixers->count() < 1)
-	{
-		// Something is wrong. Perhaps a hardware or driver or backend change. Let KMix search harder
-		recreateGUI(false, QString(), true, reset);
-	}
-
-	if (!qApp->isSessionRestored() ) // done by the session manager otherwise
-		setInitialSize();
-
-	fixConfigAfterRead();
-	connect(theKMixDeviceManager, &KMixDeviceManager::plugged, this, &KMixWindow::plugged);
-	connect(theKMixDeviceManager, &KMixDeviceManager::unplugged, this, &KMixWindow::unplugged);
-	theKMixDeviceManager->initHotplug();
-
-	if (m_startVisible && !invisible) show();	// Started visible
+	new DBusStatsWrapper(this, QStringLiteral("/Stats"));
+	if (Settings::debugTrace()) KMixTrace::setEnabled(true);
 
 	connect(qApp, SIGNAL(aboutToQuit()), SLOT(saveConfig()) );
 
@@ -107,11 +96,106 @@ KMixWindow::KMixWindow(bool invisible, bool reset) :
 			QString(), // All mixers (as the Global master Mixer might change)
 			ControlManager::ControlList|ControlManager::MasterChanged, this,
 			"KMixWindow");
+
+	// The rest of the startup runs from the event loop, each stage as soon
+	// as the stages that it needs are done.
+	m_startup = new StartupSequence(QStringLiteral("kmix"), this);
+
+	m_startup->addStage(QStringLiteral("mixers"), QStringList(), [this]()
+	{
+		// Show the controls as they were when KMix last ran, if they are
+		// known, and open the real mixers once the window is up.
+		if (Settings::startupCache() && !BackendReplay::isLoaded()) m_cachedMixers = TopologyCache::createMixers();
+		MixerStateExport::setInstanceName(QStringLiteral("kmix"));
+		if (!m_cachedMixers.isEmpty()) Mixer::mixers().append(m_cachedMixers);
+		else MixerToolBox::initMixer(m_multiDriverMode, m_backendFilter, true);
+		ControlEventServer::initialize(this, QStringLiteral("kmix-events"));
+		initActionsAfterInitMixer(); // init actions that require initialized mixer backend(s).
+	});
+
+	m_startup->addStage(QStringLiteral("gui"), { QStringLiteral("mixers") }, [this, invisible, reset]()
+	{
+		recreateGUI(false, reset);
+		if (m_wsMixers->count() < 1)
+		{
+			// Something is wrong. Perhaps a hardware or driver or backend change. Let KMix search harder
+			recreateGUI(false, QString(), true, reset);
+		}
+
+		if (!qApp->isSessionRestored() ) // done by the session manager otherwise
+			setInitialSize();
+
+		fixConfigAfterRead();
+		if (m_startVisible && !invisible) show();	// Started visible
+
+		// Send an initial volume refresh (otherwise all volumes are 0 until the next change)
+		ControlManager::instance().announce(QString(), ControlManager::Volume, "Startup");
+	});
+
+	m_startup->addStage(QStringLiteral("reconcile"), { QStringLiteral("gui") }, [this]()
+	{
+		reconcileMixers();
+	});
+
+	m_startup->addStage(QStringLiteral("hotplug"), { QStringLiteral("reconcile") }, [this]()
+	{
+		KMixDeviceManager *theKMixDeviceManager = KMixDeviceManager::instance();
+		connect(theKMixDeviceManager, &KMixDeviceManager::plugged, this, &KMixWindow::plugged);
+		connect(theKMixDeviceManager, &KMixDeviceManager::unplugged, this, &KMixWindow::unplugged);
+		theKMixDeviceManager->initHotplug();
+	});
+
+	// Registering with the global shortcut service can be slow
+	m_startup->addStage(QStringLiteral("shortcuts"), { QStringLiteral("gui") }, [this]()
+	{
+		registerGlobalShortcuts();
+	});
+
 #ifdef HAVE_CANBERRA
-	VolumeFeedback::instance()->init();		// set up for volume feedback
+	m_startup->addStage(QStringLiteral("feedback"), { QStringLiteral("gui") }, []()
+	{
+		VolumeFeedback::instance()->init();		// set up for volume feedback
+	});
 #endif
-	// Send an initial volume refresh (otherwise all volumes are 0 until the next change)
+
+	m_startup->start();
+}
+
+
+/**
+ * Replace the placeholder mixers from the topology cache by the real
+ * mixers, keeping anything that the user has changed in the meantime.
+ */
+void KMixWindow::reconcileMixers()
+{
+	if (m_cachedMixers.isEmpty())
+	{
+		// The real mixers were opened at the start, just update the cache
+		if (Settings::startupCache()) TopologyCache::save();
+		return;
+	}
+
+	Mixer::mixers().clear();
+	MixerToolBox::initMixer(m_multiDriverMode, m_backendFilter, true);
+	TopologyCache::reconcile(m_cachedMixers);
+
+	// Rebuild the tabs for the real mixers as at a normal start
+	while (m_wsMixers->count()!=0)
+	{
+		QWidget *mw = m_wsMixers->widget(0);
+		m_wsMixers->removeTab(0);
+		delete mw;
+	}
+	recreateGUI(false, false);
+	if (m_wsMixers->count() < 1) recreateGUI(false, QString(), true, false);
+
+	// Anything else that shows the placeholders rebuilds on this
+	ControlManager::instance().announce(QString(), ControlManager::ControlList, "Topology cache");
 	ControlManager::instance().announce(QString(), ControlManager::Volume, "Startup");
+
+	for (Mixer *mixer : qAsConst(m_cachedMixers)) mixer->deleteLater();
+	m_cachedMixers.clear();
+	TopologyCache::save();
 }
 
 KMixWindow::~KMixWindow()
@@ -241,23 +325,31 @@ void KMixWindow::initActionsLate()
 	{
 		QAction* globalAction = actionCollection()->addAction(QStringLiteral("increase_volume"));
 		globalAction->setText(i18n("Increase Volume"));
-
-		KGlobalAccel::setGlobalShortcut(globalAction, Qt::Key_VolumeUp);
-
 		connect(globalAction, SIGNAL(triggered(bool)), SLOT(slotIncreaseVolume()));
 
 		globalAction = actionCollection()->addAction(QStringLiteral("decrease_volume"));
 		globalAction->setText(i18n("Decrease Volume"));
-		KGlobalAccel::setGlobalShortcut(globalAction, Qt::Key_VolumeDown);
 		connect(globalAction, SIGNAL(triggered(bool)), SLOT(slotDecreaseVolume()));
 
 		globalAction = actionCollection()->addAction(QStringLiteral("mute"));
 		globalAction->setText(i18n("Mute"));
-		KGlobalAccel::setGlobalShortcut(globalAction, Qt::Key_VolumeMute);
 		connect(globalAction, SIGNAL(triggered(bool)), SLOT(slotMute()));
 	}
 }
 
+/**
+ * Register the actions created by initActionsLate() as global shortcuts.
+ * This is done as a separate startup stage, once the GUI is shown.
+ */
+void KMixWindow::registerGlobalShortcuts()
+{
+	if (!m_autouseMultimediaKeys) return;
+
+	KGlobalAccel::setGlobalShortcut(actionCollection()->action(QStringLiteral("increase_volume")), Qt::Key_VolumeUp);
+	KGlobalAccel::setGlobalShortcut(actionCollection()->action(QStringLiteral("decrease_volume")), Qt::Key_VolumeDown);
+	KGlobalAccel::setGlobalShortcut(actionCollection()->action(QStringLiteral("mute")), Qt::Key_VolumeMute);
+}
+
 void KMixWindow::initActionsAfterInitMixer()
 {
 	// Only show the new tab widget if Pulseaudio is not used. Hint: The Pulseaudio backend always
@@ -343,8 +435,10 @@ bool KMixWindow::updateDocking()
 void KMixWindow::saveConfig()
 {
 	saveBaseConfig();
-	saveViewConfig();
+	// Until the views have been created, saving them would lose them
+	if (m_startup->isFinished(QStringLiteral("gui"))) saveViewConfig();
 	saveVolumes();
+	if (Settings::startupCache()) TopologyCache::save();
 
 	// TODO cesken The reason for not writing might be that we have multiple cascaded KConfig objects. I must migrate to KSharedConfig !!!
 	KSharedConfig::openConfig()->sync();
@@ -440,15 +534,16 @@ void KMixWindow::saveVolumes(const QString &postfix)
 {
 	const QString& kmixctrlRcFilename = getKmixctrlRcFilename(postfix);
 	KConfig *cfg = new KConfig(kmixctrlRcFilename);
+	QList<Mixer *> openMixers;
 	for (int i = 0; i < Mixer::mixers().count(); ++i)
 	{
 		Mixer *mixer = (Mixer::mixers())[i];
 		if (mixer->isOpen())
 		{ // protect from unplugged devices (better do *not* save them)
-			mixer->volumeSave(cfg);
+			openMixers.append(mixer);
 		}
 	}
-	cfg->sync();
+	Mixer::volumeSaveAll(cfg, openMixers);
 	delete cfg;
 	qCDebug(KMIX_LOG)
 	<< "Volume configuration saved";
@@ -494,6 +589,8 @@ void KMixWindow::loadBaseConfig()
 	// The following log is very helpful in bug reports. Please keep it.
 	m_backendFilter = Settings::backends();
 	qCDebug(KMIX_LOG) << "Backends from settings" << m_backendFilter;
+	// A recording replaces the hardware
+	if (BackendReplay::isLoaded()) m_backendFilter = QStringList(BackendReplay::driverName());
 
 	// show/hide menu bar
 	bool showMenubar = Settings::menubar();
@@ -38,6 +38,7 @@ class KMixerWidget;
 class KMixWindow;
 class Mixer;
 class DialogSelectMaster;
+class StartupSequence;
 
 
 class KMixWindow : public KXmlGuiWindow
@@ -58,6 +59,8 @@ private:
    void initActions();
    void initActionsLate();
    void initActionsAfterInitMixer();
+   void registerGlobalShortcuts();
+   void reconcileMixers();
    void initWidgets();
 
    void fixConfigAfterRead();
@@ -106,6 +109,10 @@ private:
    QStringList m_backendFilter;
    unsigned int m_configVersion;
 
+   // Placeholders from the topology cache, until the real mixers are opened
+   QList<Mixer *> m_cachedMixers;
+   StartupSequence *m_startup;
+
 private:
     void showVolumeDisplay();
     void increaseOrDecreaseVolume(bool increase);
@@ -74,6 +74,9 @@ int main(int argc, char *argv[])
    aboutData.setupCommandLine(&parser);
    parser.addOption(QCommandLineOption("keepvisibility", i18n("Inhibits the unhiding of the KMix main window, if KMix is already running.")));
    parser.addOption(QCommandLineOption("failsafe", i18n("Starts KMix in failsafe mode.")));
+   parser.addOption(QCommandLineOption("record", i18n("Records what is read from the sound hardware to a file."), i18n("file")));
+   parser.addOption(QCommandLineOption("replay", i18n("Replays a recording instead of using the sound hardware."), i18n("file")));
+   parser.addOption(QCommandLineOption("replay-speed", i18n("How many times faster to replay, 0 for as fast as possible."), i18n("factor")));
    parser.process(qapp);
    kmapp.parseOptions(parser);				// pass options for startup
 
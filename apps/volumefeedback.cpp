@@ -76,6 +76,8 @@ VolumeFeedback::VolumeFeedback()
 					       ControlManager::MasterChanged,	// type of change
 					       this,				// receiver
 					       "VolumeFeedback (master)");	// source ID
+	// Feedback is for the user's own changes, which are seen without polling
+	ControlManager::instance().setListenerActive(this, false);
 }
 
 
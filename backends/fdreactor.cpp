@@ -0,0 +1,218 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "backends/fdreactor.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <QCoreApplication>
+#include <QSet>
+
+#include "backends/mixer_backend.h"
+#include "core/kmixtrace.h"
+#include "kmix_debug.h"
+
+// The most events that are handled by one wakeup
+#define MAX_EVENTS 64
+
+
+// Only changed from the main thread, when no backends are open
+static FdReactor *instanceSingleton = nullptr;
+
+
+FdReactor *FdReactor::instance()
+{
+	return (instanceSingleton);
+}
+
+
+/**
+ * Start the reactor.  This must be called from the main thread, before
+ * any backends that use it are opened, so that the thread belongs to
+ * the application and not to whichever thread happens to open the first
+ * backend.
+ */
+void FdReactor::startInstance()
+{
+	Q_ASSERT(QThread::currentThread()==QCoreApplication::instance()->thread());
+	if (instanceSingleton!=nullptr) return;
+
+	const int epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+	if (epollFd<0)
+	{
+		qCWarning(KMIX_LOG) << "Cannot create epoll instance:" << strerror(errno);
+		return;
+	}
+
+	const int wakeFd = ::eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+	if (wakeFd<0)
+	{
+		qCWarning(KMIX_LOG) << "Cannot create eventfd:" << strerror(errno);
+		::close(epollFd);
+		return;
+	}
+
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u64 = 0;
+	if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev)<0)
+	{
+		qCWarning(KMIX_LOG) << "Cannot watch eventfd:" << strerror(errno);
+		::close(wakeFd);
+		::close(epollFd);
+		return;
+	}
+
+	instanceSingleton = new FdReactor(epollFd, wakeFd);
+	instanceSingleton->start();
+}
+
+
+/**
+ * Stop the reactor, when all of the backends that use it have been
+ * closed, e.g. when KMix exits or the kded module is unloaded.
+ */
+void FdReactor::stopInstance()
+{
+	Q_ASSERT(QThread::currentThread()==QCoreApplication::instance()->thread());
+	if (instanceSingleton==nullptr) return;
+
+	const quint64 one = 1;
+	if (::write(instanceSingleton->m_wakeFd, &one, sizeof(one))<0)
+	{
+		qCWarning(KMIX_LOG) << "Cannot wake reactor:" << strerror(errno);
+	}
+	instanceSingleton->wait();
+
+	delete instanceSingleton;
+	instanceSingleton = nullptr;
+}
+
+
+FdReactor::FdReactor(int epollFd, int wakeFd)
+	: m_epollFd(epollFd),
+	  m_wakeFd(wakeFd),
+	  m_lastToken(0)
+{
+	setObjectName("FdReactor");
+}
+
+
+FdReactor::~FdReactor()
+{
+	::close(m_wakeFd);
+	::close(m_epollFd);
+}
+
+
+void FdReactor::control(int op, const Watch &watch)
+{
+	for (int fd : watch.fds)
+	{
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN|EPOLLONESHOT;
+		ev.data.u64 = watch.token;
+		if (::epoll_ctl(m_epollFd, op, fd, &ev)<0)
+		{
+			qCWarning(KMIX_LOG) << "epoll_ctl" << op << "fd" << fd << "failed:" << strerror(errno);
+		}
+	}
+}
+
+
+void FdReactor::watch(Mixer_Backend *backend, const QList<int> &fds)
+{
+	QMutexLocker locker(&m_mutex);
+
+	Watch &watch = m_watches[backend];
+	if (watch.token!=0)
+	{
+		if (watch.fds==fds) return;		// nothing to change
+		control(EPOLL_CTL_DEL, watch);
+		m_backends.remove(watch.token);
+	}
+
+	watch.token = ++m_lastToken;
+	watch.fds = fds;
+	m_backends.insert(watch.token, backend);
+	control(EPOLL_CTL_ADD, watch);
+}
+
+
+void FdReactor::unwatch(Mixer_Backend *backend)
+{
+	QMutexLocker locker(&m_mutex);
+
+	QHash<Mixer_Backend *,Watch>::iterator it = m_watches.find(backend);
+	if (it==m_watches.end()) return;
+
+	control(EPOLL_CTL_DEL, it.value());
+	m_backends.remove(it.value().token);
+	m_watches.erase(it);
+}
+
+
+void FdReactor::rearm(Mixer_Backend *backend)
+{
+	QMutexLocker locker(&m_mutex);
+
+	QHash<Mixer_Backend *,Watch>::const_iterator it = m_watches.constFind(backend);
+	if (it==m_watches.constEnd()) return;
+	control(EPOLL_CTL_MOD, it.value());
+}
+
+
+void FdReactor::run()
+{
+	struct epoll_event events[MAX_EVENTS];
+
+	forever
+	{
+		const int count = ::epoll_wait(m_epollFd, events, MAX_EVENTS, -1);
+		if (count<0)
+		{
+			if (errno==EINTR) continue;
+			qCWarning(KMIX_LOG) << "epoll_wait failed:" << strerror(errno);
+			return;
+		}
+
+		// Call each backend only once, however many of its descriptors are ready
+		QSet<quint64> tokens;
+		for (int i = 0; i<count; ++i) tokens.insert(events[i].data.u64);
+		if (tokens.contains(0)) return;		// woken by stopInstance()
+
+		// The lock is held while posting, so that unwatch() returning
+		// means that there will be no more calls for that backend.
+		// Any that are already posted when its Mixer is deleted are
+		// ignored, see Mixer_Backend::readSetFromHW().
+		QMutexLocker locker(&m_mutex);
+		for (quint64 token : qAsConst(tokens))
+		{
+			Mixer_Backend *backend = m_backends.value(token);
+			if (backend==nullptr) continue;		// unwatched meanwhile
+			KMixTrace::instant("readable", "backend", backend->getId());
+			QMetaObject::invokeMethod(backend, "readSetFromHW", Qt::QueuedConnection);
+		}
+	}
+}
@@ -0,0 +1,100 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef FDREACTOR_H
+#define FDREACTOR_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+
+class Mixer_Backend;
+
+/**
+ * Waits for the file descriptors of all backends in a single thread
+ * using epoll, instead of with a QSocketNotifier for each descriptor
+ * in the GUI event loop.
+ *
+ * When any of the descriptors of a backend become readable, the
+ * backend's readSetFromHW() is called once, from the event loop of
+ * the thread that the backend lives in.  The descriptors are then not
+ * watched again until the backend calls rearm(), normally as soon as
+ * it has handled the events.  All of the descriptors that are ready
+ * at the same time are handled by one wakeup of the reactor.
+ *
+ * This is only available where epoll is (see HAVE_EPOLL).  The reactor
+ * is started by startInstance() from the main thread before any mixers
+ * are opened, and stopped by stopInstance() after they have all been
+ * closed.  instance() returns null if it is not running.
+ */
+class FdReactor : public QThread
+{
+	public:
+		static FdReactor *instance();
+
+		/// Start the reactor thread, if it is not already running
+		static void startInstance();
+		/// Stop the reactor thread and wait for it to finish
+		static void stopInstance();
+
+		/**
+		 * Watch the descriptors of a backend for reading,
+		 * replacing any that were watched for it before.  If
+		 * they are the same as before, nothing is changed.
+		 */
+		void watch(Mixer_Backend *backend, const QList<int> &fds);
+
+		/**
+		 * Stop watching the descriptors of a backend.  This must
+		 * be done before they are closed.
+		 */
+		void unwatch(Mixer_Backend *backend);
+
+		/**
+		 * Watch the descriptors of a backend again, after it
+		 * has been called for them.
+		 */
+		void rearm(Mixer_Backend *backend);
+
+	protected:
+		void run() override;
+
+	private:
+		FdReactor(int epollFd, int wakeFd);
+		~FdReactor();
+
+		struct Watch
+		{
+			quint64 token = 0;			// 0 is the wakeup descriptor
+			QList<int> fds;
+		};
+
+		void control(int op, const Watch &watch);
+
+		int m_epollFd;
+		int m_wakeFd;				// an eventfd, to stop run()
+		QMutex m_mutex;
+		quint64 m_lastToken;
+		// A token is never reused, so that an event for a backend
+		// that was unwatched meanwhile cannot reach another one
+		QHash<Mixer_Backend *,Watch> m_watches;
+		QHash<quint64,Mixer_Backend *> m_backends;
+};
+
+#endif /* FDREACTOR_H */
@@ -80,6 +80,9 @@ QString ALSA_getDriverName();
 Mixer_Backend* PULSE_getMixer(Mixer *mixer, int device );
 QString PULSE_getDriverName();
 
+Mixer_Backend* REPLAY_getMixer(Mixer *mixer, int device );
+QString REPLAY_getDriverName();
+
 MixerFactory g_mixerFactories[] = {
 
 #if defined(SUN_MIXER)
@@ -102,6 +105,9 @@ MixerFactory g_mixerFactories[] = {
     { OSS4_getMixer, OSS4_getDriverName },
 #endif
 
+    // Only opens anything if a recording is being replayed
+    { REPLAY_getMixer, REPLAY_getDriverName },
+
     // Make sure MPRIS2 is at the end. Implementation of SINGLE_PLUS_MPRIS2 in MixerToolBox is much easier.
     // And also we make sure, streams are always the last backend, which is important for the default KMix GUI layout.
     { MPRIS2_getMixer, MPRIS2_getDriverName },
@@ -25,6 +25,11 @@
 
 // Own
 #include "mixer_alsa9.h"
+#ifdef HAVE_EPOLL
+#include "fdreactor.h"
+#endif
+
+#include <atomic>
 
 // KMix
 #include "core/kmixdevicemanager.h"
@@ -55,6 +60,7 @@ ALSA_getMixer(Mixer *mixer, int device )
 Mixer_ALSA::Mixer_ALSA( Mixer* mixer, int device ) : Mixer_Backend(mixer,  device )
 {
     m_fds = 0;
+    m_fdCount = 0;
     _handle = 0;
     ctl_handle = 0;
     _initialUpdate = true;
@@ -273,7 +279,8 @@ int Mixer_ALSA::openAlsaDevice(const QString& devName)
 {
     int err;
     // warnOnce will make sure we only print the first ALSA device not found
-    static bool warnOnce = true;
+    // (atomic, as devices may be probed in parallel)
+    static std::atomic<bool> warnOnce(true);
 
     QString probeMessage;
     probeMessage += "Trying ALSA Device '" + devName + "': ";
@@ -395,6 +402,7 @@ int Mixer_ALSA::setupAlsaPolling()
 
 
 		free(m_fds);
+		m_fdCount = 0;
 		m_fds = static_cast<struct pollfd *>(calloc(countNew, sizeof(struct pollfd)));
 		if (m_fds == NULL) {
 			qCDebug(KMIX_LOG) << "Mixer_ALSA::poll() , calloc() = null" << "\n";
@@ -412,12 +420,27 @@ int Mixer_ALSA::setupAlsaPolling()
 		}
 
 
-		// --- Step 2: Create QSocketNotifier's for the FD's
-		for ( int i = 0; i < countNew; ++i )
+		m_fdCount = countNew;
+
+		// --- Step 2: Watch the FD's, with the reactor if there is one
+#ifdef HAVE_EPOLL
+		FdReactor *reactor = FdReactor::instance();
+		if (reactor!=nullptr)
+		{
+			QList<int> fds;
+			for ( int i = 0; i < countNew; ++i ) fds.append(m_fds[i].fd);
+			reactor->watch(this, fds);		// nothing to do if they are unchanged
+		}
+		else
+#endif
 		{
-			QSocketNotifier* qsn = new QSocketNotifier(m_fds[i].fd, QSocketNotifier::Read);
-			m_sns.append(qsn);
-			connect(qsn, SIGNAL(activated(int)), SLOT(readSetFromHW()), Qt::QueuedConnection);
+			// Otherwise create QSocketNotifier's for the FD's
+			for ( int i = 0; i < countNew; ++i )
+			{
+				QSocketNotifier* qsn = new QSocketNotifier(m_fds[i].fd, QSocketNotifier::Read, this);
+				m_sns.append(qsn);
+				connect(qsn, SIGNAL(activated(int)), SLOT(readSetFromHW()), Qt::QueuedConnection);
+			}
 		}
 	}
 
@@ -506,9 +529,15 @@ Volume* Mixer_ALSA::addVolume(snd_mixer_elem_t *elem, bool capture)
 
 void Mixer_ALSA::deinitAlsaPolling()
 {
+#ifdef HAVE_EPOLL
+	FdReactor *reactor = FdReactor::instance();
+	if (reactor!=nullptr) reactor->unwatch(this);
+#endif
+
 	if ( m_fds )
 		free( m_fds );
 	m_fds = 0;
+	m_fdCount = 0;
 
 	while (!m_sns.isEmpty())
 		delete m_sns.takeFirst();
@@ -522,6 +551,9 @@ Mixer_ALSA::close()
   int ret=0;
   m_isOpen = false;
 
+  // Before the handle is closed, as the reactor must not see its FD's closed
+  deinitAlsaPolling();
+
   if ( ctl_handle != 0)
   {
 	  //snd_ctl_close( ctl_handle );
@@ -552,8 +584,6 @@ Mixer_ALSA::close()
   mixer_sid_list.clear();
   m_id2numHash.clear();
 
-  deinitAlsaPolling();
-
   closeCommon();
   return ret;
 }
@@ -611,12 +641,13 @@ bool Mixer_ALSA::hasChangedControls() {
     // Poll on fds with 10ms timeout
     // Hint: alsamixer has an infinite timeout, but we cannot do this because we would block
     // the X11 event handling (Qt event loop) with this.
-    int finished = poll(m_fds, m_sns.size(), 10); // TODO Could we pass 0 as timeout here? It makes  no real sense to wait!
+    int finished = poll(m_fds, m_fdCount, 10); // TODO Could we pass 0 as timeout here? It makes  no real sense to wait!
 
+    bool changed = false;
     if (finished > 0)
     {
         unsigned short revents;
-        if (snd_mixer_poll_descriptors_revents(_handle, m_fds, m_sns.size(), &revents) >= 0)
+        if (snd_mixer_poll_descriptors_revents(_handle, m_fds, m_fdCount, &revents) >= 0)
         {
             if (revents & POLLNVAL)
             {
@@ -641,7 +672,7 @@ bool Mixer_ALSA::hasChangedControls() {
                 	 * On the other hand, this means I can not likely detect changes
                 	 */
 //                	qCDebug(KMIX_LOG)  << "Mixer_ALSA::poll() delivered changes. eventCount=" << eventCount;
-                	return true;
+                	changed = true;
                 }
                 else
                 {
@@ -651,7 +682,12 @@ bool Mixer_ALSA::hasChangedControls() {
         }
     }
 
-    return false;
+#ifdef HAVE_EPOLL
+    // The events have been handled, so the reactor can watch for more
+    FdReactor *reactor = FdReactor::instance();
+    if (reactor!=nullptr && m_isOpen) reactor->rearm(this);
+#endif
+    return changed;
 }
 
 bool Mixer_ALSA::isRecsrcHW( const QString& id )
@@ -984,3 +1020,8 @@ QString Mixer_ALSA::getDriverName()
 {
 	return QStringLiteral("ALSA");
 }
+
+QString Mixer_ALSA::driverVersion() const
+{
+	return (QString::fromLatin1(snd_asoundlib_version()));
+}
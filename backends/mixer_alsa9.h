@@ -48,6 +48,7 @@ public:
 
     bool needsPolling() override			{ return (false); }
     QString getDriverName() override;
+    QString driverVersion() const override;
 
 protected:
     int open() override;
@@ -81,6 +82,7 @@ private:
 
     QString devName;
     struct pollfd  *m_fds;
+    int m_fdCount;
     QList<QSocketNotifier*> m_sns;
 
     QByteArray m_deviceName;
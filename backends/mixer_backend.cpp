@@ -25,29 +25,42 @@
 // for the "ERR_" declarations, #include mixer.h
 #include "core/mixer.h"
 #include "core/ControlManager.h"
-
+#include "core/backendrecorder.h"
+#include "core/kmixstats.h"
+#include "core/kmixtrace.h"
+#include "backends/pollscheduler.h"
+#ifdef HAVE_EPOLL
+#include "backends/fdreactor.h"
+#endif
+
+#include <QElapsedTimer>
 #include <QTimer>
 
-#define POLL_RATE_SLOW 1500
-#define POLL_RATE_FAST 50
+// The delay before the initial state of a backend that does not need polling is read
+#define INITIAL_READ_DELAY 50
 
 
 #include "mixer_backend_i18n.cpp"
 
 Mixer_Backend::Mixer_Backend(Mixer *mixer, int device) :
-m_devnum (device) , m_isOpen(false), m_recommendedMaster(), _mixer(mixer), _pollingTimer(0), _cardInstance(1), _cardRegistered(false)
+m_devnum (device) , m_isOpen(false), m_recommendedMaster(), _mixer(mixer), _isPolled(false), _cardInstance(1), _cardRegistered(false)
 
 {
-	// In all cases create a QTimer. We will use it once as a singleShot(), even if something smart
-	// like ::select() is possible (as in ALSA). And force to do an update.
+	// Force an update on the first read, even if something smart like ::select()
+	// is possible (as in ALSA).
 	_readSetFromHWforceUpdate = true;
-	_pollingTimer = new QTimer(); // will be started on open() and stopped on close()
-	connect( _pollingTimer, SIGNAL(timeout()), this, SLOT(readSetFromHW()), Qt::QueuedConnection);
-
+	_readConfirmsWrites = true;
 }
 
 void Mixer_Backend::closeCommon()
 {
+	stopPolling();
+#ifdef HAVE_EPOLL
+	// Now, and not when the backend closes its descriptors, as the backend
+	// is only deleted later and its Mixer may be gone by then
+	FdReactor *reactor = FdReactor::instance();
+	if (reactor!=nullptr) reactor->unwatch(this);
+#endif
 	freeMixDevices();
 }
 
@@ -71,17 +84,29 @@ Mixer_Backend::~Mixer_Backend()
 	{
 		qCDebug(KMIX_LOG) << "Implicit close on " << this << ". Please instead call closeCommon() and close() explicitly (in concrete Backend destructor)";
 	}
-	delete _pollingTimer;
+	stopPolling();
 }
 
 void Mixer_Backend::freeMixDevices()
 {
-	for (shared_ptr<MixDevice> md : qAsConst(m_mixDevices)) md->close();
 	m_mixDevices.clear();
 }
 
 
 bool Mixer_Backend::openIfValid()
+{
+	if (!probe()) return (false);
+	startPolling();
+	return (true);
+}
+
+
+/**
+ * Opens the mixer and checks whether it is valid, as for openIfValid(),
+ * but without starting to poll it.  This may be run in a thread other
+ * than the one that the backend will be used in.
+ */
+bool Mixer_Backend::probe()
 {
 	const int ret = open();
 	if (ret!=0)
@@ -94,15 +119,6 @@ bool Mixer_Backend::openIfValid()
 			  << "dynamic?" << _mixer->isDynamic() << "needsPolling?" << needsPolling();
 	if (m_mixDevices.count() > 0 || _mixer->isDynamic())
 	{
-		if (needsPolling())
-		{
-			_pollingTimer->start(POLL_RATE_FAST);
-		}
-		else
-		{
-			// The initial state must be read manually
-			QTimer::singleShot( POLL_RATE_FAST, this, SLOT(readSetFromHW()));
-		}
 		return true;				// could be opened
 	}
 	else
@@ -113,6 +129,37 @@ bool Mixer_Backend::openIfValid()
 }
 
 
+/**
+ * Starts polling, or reads the initial state if the backend does not
+ * need polling.  This must be called in the thread that the backend
+ * lives in, after a successful probe().
+ */
+void Mixer_Backend::startPolling()
+{
+	if (needsPolling())
+	{
+		PollScheduler::instance()->add(this);
+		_isPolled = true;
+	}
+	else
+	{
+		// The initial state must be read manually
+		QTimer::singleShot(INITIAL_READ_DELAY, this, SLOT(readSetFromHW()));
+	}
+}
+
+
+/**
+ * Stops polling, e.g. when the mixer is closed.
+ */
+void Mixer_Backend::stopPolling()
+{
+	if (!_isPolled) return;
+	PollScheduler::instance()->remove(this);
+	_isPolled = false;
+}
+
+
 bool Mixer_Backend::isOpen() {
 	return m_isOpen;
 }
@@ -169,17 +216,29 @@ void Mixer_Backend::readSetFromHWforceUpdate() const
  */
 void Mixer_Backend::readSetFromHW()
 {
+	// A call that was queued before the Mixer was deleted, see Mixer::~Mixer()
+	if (_mixer==nullptr) return;
+
+	KMixTrace::Span span("readSetFromHW", "backend", _mixer->id());
+	QElapsedTimer timer;
+	timer.start();
+
 	bool updated = hasChangedControls();
 	if ( (! updated) && (! _readSetFromHWforceUpdate) ) {
 		// Some drivers (ALSA) are smart. We don't need to run the following
 		// time-consuming update loop if there was no change
 		qCDebug(KMIX_LOG) << "smart-update-tick";
+		if ( needsPolling() ) PollScheduler::instance()->polled(this, false);
+		KMixStats::readSet(_mixer->id(), timer.nsecsElapsed(), 0, 0);
 		return;
 	}
 
 	_readSetFromHWforceUpdate = false;
 
 	int ret = Mixer::OK_UNCHANGED;
+	int controlsChanged = 0;
+	const bool recording = BackendRecorder::isRecording();
+	QList<shared_ptr<MixDevice> > changedControls;
 
 	for (shared_ptr<MixDevice> md : qAsConst(m_mixDevices))
 	{
@@ -188,7 +247,11 @@ void Mixer_Backend::readSetFromHW()
 	  if (debugMe) qCDebug(KMIX_LOG) << "Old PCM:0 playback state" << md->isMuted()
 	    << ", vol=" << md->playbackVolume().getAvgVolumePercent(Volume::MALL);
 	    
-		int retLoop = readVolumeFromHW( md->id(), md );
+		int retLoop;
+		{
+			KMixTrace::Span controlSpan("readVolumeFromHW", "backend", md->id());
+			retLoop = readVolumeFromHW( md->id(), md );
+		}
 	  if (debugMe) qCDebug(KMIX_LOG) << "New PCM:0 playback state" << md->isMuted()
 	    << ", vol=" << md->playbackVolume().getAvgVolumePercent(Volume::MALL);
 		if (md->isEnum() )
@@ -201,6 +264,13 @@ void Mixer_Backend::readSetFromHW()
 			md->setEnumId( enumIdHW(md->id()) );
 		}
 
+		if ( retLoop == Mixer::OK )
+		{
+			++controlsChanged;
+			if ( recording ) changedControls.append(md);
+		}
+		if ( _readConfirmsWrites && !confirmsWrites() ) writeConfirmed(md->id());
+
 		// Transition the outer return value with the value from this loop iteration
 		if ( retLoop == Mixer::OK && ret == Mixer::OK_UNCHANGED )
 		{
@@ -214,34 +284,17 @@ void Mixer_Backend::readSetFromHW()
 		}
 	}
 
+	KMixStats::readSet(_mixer->id(), timer.nsecsElapsed(), m_mixDevices.count(), controlsChanged);
+	if ( recording ) BackendRecorder::recordValues(_mixer, changedControls);
+
+	// A change found by polling keeps the poll rate up, to be more smoooooth
+	if ( needsPolling() ) PollScheduler::instance()->polled(this, ret == Mixer::OK);
+
 	if ( ret == Mixer::OK )
 	{
 		// We explicitly exclude Mixer::OK_UNCHANGED and Mixer::ERROR_READ
-		if ( needsPolling() )
-		{
-			// Upgrade polling frequency temporarily to be more smoooooth
-			_pollingTimer->setInterval(POLL_RATE_FAST);
-			QTime fastPollingEndsAt = QTime::currentTime ();
-			fastPollingEndsAt = fastPollingEndsAt.addSecs(5);
-			_fastPollingEndsAt = fastPollingEndsAt;
-			//_fastPollingEndsAt = fastPollingEndsAt;
-			qCDebug(KMIX_LOG) << "Start fast polling from " << QTime::currentTime() <<"until " << _fastPollingEndsAt;
-		}
-
 		ControlManager::instance().announce(_mixer->id(), ControlManager::Volume, QString("Mixer.fromHW"));
 	}
-
-	else
-	{
-		// This code path is entered on Mixer::OK_UNCHANGED and ERROR
-		bool fastPollingEndsNow = (!_fastPollingEndsAt.isNull()) && _fastPollingEndsAt < QTime::currentTime ();
-		if ( fastPollingEndsNow )
-		{
-			qCDebug(KMIX_LOG) << "End fast polling";
-			_fastPollingEndsAt = QTime(); // NULL time
-			_pollingTimer->setInterval(POLL_RATE_SLOW);
-		}
-	}
 }
 
 /**
@@ -274,6 +327,31 @@ shared_ptr<MixDevice> Mixer_Backend::recommendedMaster()
 
 }
 
+void Mixer_Backend::writeConfirmed(const QString &id)
+{
+	if (_mixer==nullptr) return;			// the Mixer has been deleted
+	KMixStats::writeConfirmed(_mixer->id(), getDriverName(), id);
+}
+
+
+/**
+ * Write the volumes of a number of controls to the hardware.
+ * This implementation writes them one after the other. A backend that
+ * can submit several changes at once should override this method.
+ *
+ * @return the result of writing each control, in the order of @p mds
+ */
+QList<int> Mixer_Backend::writeVolumesToHW(const QList<shared_ptr<MixDevice> > &mds)
+{
+	QList<int> results;
+	for (const shared_ptr<MixDevice> &md : mds)
+	{
+		results.append(writeVolumeToHW(md->id(), md));
+		if (md->isEnum()) setEnumIdHW(md->id(), md->enumId());
+	}
+	return (results);
+}
+
 /**
  * Sets the ID of the currently selected Enum entry.
  * This is a dummy implementation - if the Mixer backend
@@ -23,20 +23,20 @@
 #define MIXER_BACKEND_H
 
 #include <QString>
-#include <QTime>
-#include <QTimer>
 #include "core/mixdevice.h"
 #include "core/mixset.h"
 #include "kmix_debug.h"
+#include "kmixcore_export.h"
 
 class Mixer;
 
 
-class Mixer_Backend : public QObject
+class KMIXCORE_EXPORT Mixer_Backend : public QObject
 {
       Q_OBJECT
 
 friend class Mixer;
+friend class PollScheduler;
 
 // The Mixer Backend's may only be accessed from the Mixer class.
 protected:
@@ -75,6 +75,12 @@ protected:
    */
   virtual QString getDriverName() = 0;
 
+  /**
+   * Returns the version of the driver or its library, if it is known.  This is
+   * saved with the cached controls, to know when they may have changed.
+   */
+  virtual QString driverVersion() const		{ return (QString()); }
+
   /**
    * Opens the mixer, if it constitutes a valid Device. You should return "false", when
    * the Mixer with the devnum given in the constructor is not supported by the Backend. The two
@@ -85,6 +91,10 @@ protected:
    * supported channels is > 0. The device remains opened if it is valid, otherwise a close() is done.
    */
   bool openIfValid();
+  /// The two halves of openIfValid(), see there
+  bool probe();
+  void startPolling();
+  void stopPolling();
 
   /** @return true, if the Mixer is open (and thus can be operated) */
   bool isOpen();
@@ -96,6 +106,8 @@ protected:
   virtual int readVolumeFromHW( const QString& id, shared_ptr<MixDevice> ) = 0;
   /// Volume Write
   virtual int writeVolumeToHW( const QString& id, shared_ptr<MixDevice> ) = 0;
+  /// Volume Write of several controls at once, returns a Mixer::MixerError for each
+  virtual QList<int> writeVolumesToHW(const QList<shared_ptr<MixDevice> > &mds);
 
   /// Enums
   virtual void setEnumIdHW(const QString& id, unsigned int);
@@ -112,6 +124,15 @@ protected:
   /// Overwrite in the backend if the backend can see changes without polling
   virtual bool needsPolling() { return true; }
 
+  /**
+   * Overwrite in the backend if it calls writeConfirmed() itself when the
+   * hardware reports back a particular control.  Otherwise any read of the
+   * control by readSetFromHW() confirms a write to it.
+   */
+  virtual bool confirmsWrites() const { return false; }
+  /// The hardware has reported the current value of the control @p id
+  void writeConfirmed(const QString &id);
+
   shared_ptr<MixDevice> recommendedMaster();
 
   /**
@@ -150,11 +171,13 @@ protected:
    // but just believe me. It's *really* better, for example, you can put controls of different soundcards in
    // one View. That is very cool! Also the MDW doesn't need to store the Mixer any longer (MDW is a GUI element,
    // so that was 'wrong' anyhow
+   // It is null once the Mixer has been deleted, see Mixer::~Mixer().
   Mixer* _mixer;
-  QTimer* _pollingTimer;
+  bool _isPolled;  // whether the PollScheduler is polling this backend
   QString _udi;  // Universal Device Identification
 
   mutable bool _readSetFromHWforceUpdate;
+  bool _readConfirmsWrites;  // whether readSetFromHW() confirms writes, see confirmsWrites()
 
 signals:
   void controlChanged( void ); // TODO remove?
@@ -228,7 +251,6 @@ protected:
 protected slots:
   virtual void readSetFromHW();
 private:
-  QTime _fastPollingEndsAt;
   QString m_mixerName;
 };
 
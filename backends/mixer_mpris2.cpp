@@ -24,6 +24,8 @@
 
 #include "core/mixer.h"
 #include "core/ControlManager.h"
+#include "core/backendrecorder.h"
+#include "core/kmixstats.h"
 #include "kmix_debug.h"
 #include "settings.h"
 
@@ -159,6 +161,9 @@ void Mixer_MPRIS2::volumeChanged(MPrisControl* mad, double newVolume)
 
 void Mixer_MPRIS2::volumeChangedInternal(shared_ptr<MixDevice> md, int volumePercentage)
 {
+	// Also for a virtually muted control, which is not updated below
+	writeConfirmed(md->id());
+
 	if ( md->isVirtuallyMuted() && volumePercentage == 0)
 	{
 		// Special code path for virtual mute switches. Don't write back the volume if it is muted in the KMix GUI
@@ -168,6 +173,11 @@ void Mixer_MPRIS2::volumeChangedInternal(shared_ptr<MixDevice> md, int volumePer
 	Volume& vol = md->playbackVolume();
 	vol.setVolume( Volume::LEFT, volumePercentage);
 	md->setMuted(volumePercentage == 0);
+	if (BackendRecorder::isRecording())
+	{
+		BackendRecorder::recordEvent(_mixer->id(), QString("PropertiesChanged ") + md->id());
+		BackendRecorder::recordValues(_mixer, QList<shared_ptr<MixDevice> >() << md);
+	}
 	QMetaObject::invokeMethod(this, "announceVolume", Qt::QueuedConnection);
 //	ControlManager::instance().announce(_mixer->id(), ControlManager::Volume, QString("MixerMPRIS2.volumeChanged"));
 }
@@ -636,8 +646,8 @@ void Mixer_MPRIS2::newMediaPlayer(QString name, QString oldOwner, QString newOwn
 			if (md)
 			{
 				// We know about the player that is unregistering => remove internally
-				md->close();
 				m_mixDevices.removeById(id);
+				if (_mixer!=nullptr) KMixStats::writesDropped(_mixer->id(), id);
 				announceControlListAsync(id);
 				qCDebug(KMIX_LOG) << "MixDevice 4 useCount=" << md.use_count();
 			}
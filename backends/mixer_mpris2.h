@@ -125,6 +125,8 @@ public:
   void setEnumIdHW(const QString& id, unsigned int) override;
   unsigned int enumIdHW(const QString& id) override;
   bool needsPolling() override { return false; }
+  // The PropertiesChanged echo of a write confirms it
+  bool confirmsWrites() const override { return true; }
 
   int mediaPlay(QString id) override;
   int mediaPrev(QString id) override;
@@ -24,6 +24,7 @@
 #include "core/mixer.h"
 
 #include <errno.h>
+#include <string.h>
 #include <fcntl.h>
 #include <qplatformdefs.h>
 #include <sys/ioctl.h>
@@ -115,6 +116,8 @@ Mixer_OSS::Mixer_OSS(Mixer *mixer, int device)
         m_devnum = 0;
     }
     m_fd = -1; // point to an invalid FD
+    m_snapshotValid = false;
+    m_snapshotCurrent = false;
 }
 
 Mixer_OSS::~Mixer_OSS()
@@ -201,8 +204,10 @@ int Mixer_OSS::open()
 
 int Mixer_OSS::close()
 {
-    _pollingTimer->stop();
+    stopPolling();
     m_isOpen = false;
+    m_snapshotValid = false;
+    m_snapshotCurrent = false;
     int l_i_ret = ::close(m_fd);
     closeCommon();
     return l_i_ret;
@@ -346,90 +351,153 @@ void Mixer_OSS::errormsg(int mixer_error)
     qCCritical(KMIX_LOG) << l_s_errText << "\n";
 }
 
-int Mixer_OSS::readVolumeFromHW(const QString &id, shared_ptr<MixDevice> md)
+/**
+ * Reads the state of the whole mixer in one pass: the masks, the record
+ * sources and the levels of all devices.
+ *
+ * @return true if all of it could be read
+ */
+bool Mixer_OSS::takeSnapshot(Snapshot *snapshot)
 {
-    int ret = 0;
+    memset(snapshot, 0, sizeof(Snapshot));
+    if (ioctl(m_fd, SOUND_MIXER_READ_DEVMASK, &snapshot->devmask) == -1)
+        return false;
+    if (ioctl(m_fd, SOUND_MIXER_READ_RECMASK, &snapshot->recmask) == -1)
+        return false;
+    if (ioctl(m_fd, SOUND_MIXER_READ_RECSRC, &snapshot->recsrc) == -1)
+        return false;
+
+    for (int idx = 0; idx < MAX_MIXDEVS; idx++) {
+        if ((snapshot->devmask & (1 << idx)) == 0)
+            continue;
+        if (ioctl(m_fd, MIXER_READ(idx), &snapshot->levels[idx]) == -1)
+            return false;
+    }
+    return true;
+}
 
-    // --- VOLUME ---
-    Volume &vol = md->playbackVolume();
+/**
+ * OSS cannot tell what has changed, so take a snapshot of the mixer and
+ * compare it with the previous one.  If nothing has changed, no control
+ * needs to be looked at.
+ */
+bool Mixer_OSS::hasChangedControls()
+{
+    Snapshot snapshot;
+    if (!takeSnapshot(&snapshot)) {
+        // Let readVolumeFromHW() read, and report the error, for each control
+        m_snapshotValid = false;
+        m_snapshotCurrent = false;
+        return true;
+    }
+
+    const bool changed = !m_snapshotValid || memcmp(&snapshot, &m_snapshot, sizeof(Snapshot)) != 0;
+    m_snapshot = snapshot;
+    m_snapshotValid = true;
+    m_snapshotCurrent = true;
+    return changed;
+}
+
+void Mixer_OSS::readSetFromHW()
+{
+    Mixer_Backend::readSetFromHW();
+    // Any other reads must go to the hardware
+    m_snapshotCurrent = false;
+}
+
+int Mixer_OSS::readVolumeFromHW(const QString &id, shared_ptr<MixDevice> md)
+{
     int devnum = id2num(id);
+    if (devnum < 0 || devnum >= MAX_MIXDEVS)
+        return Mixer::ERR_READ;
 
-    bool controlChanged = false;
+    // Within readSetFromHW(), use the snapshot that was just taken
+    if (m_snapshotCurrent) {
+        const bool controlChanged = applyState(md, devnum, m_snapshot.levels[devnum], m_snapshot.recsrc);
+        return (controlChanged ? Mixer::OK : Mixer::OK_UNCHANGED);
+    }
 
-    if (vol.hasVolume()) {
-        int volume;
+    int volume = 0;
+    if (md->playbackVolume().hasVolume()) {
         if (ioctl(m_fd, MIXER_READ(devnum), &volume) == -1) {
             /* Oops, can't read mixer */
             errormsg(Mixer::ERR_READ);
-            ret = Mixer::ERR_READ;
-        } else {
-
-            int volLeft = (volume & 0x7f);
-            int volRight = ((volume >> 8) & 0x7f);
-            //
-            //			if ( md->id() == "0" )
-            //				qCDebug(KMIX_LOG) << md->id() << ": " << "volLeft=" << volLeft << ", volRight" << volRight;
-
-            bool isMuted = volLeft == 0 && (vol.count() < 2 || volRight == 0); // muted is "left and right muted" or "left muted when mono"
-            md->setMuted(isMuted);
-            if (!isMuted) {
-                // Muted is represented in OSS by value 0. We don't want to write the value 0 as a volume,
-                // but instead we only mark it muted (see setMuted() above).
-
-                for (const VolumeChannel &vc : qAsConst(vol.getVolumes()))
-                {
-                    long volOld = 0;
-                    long volNew = 0;
-                    switch (vc.chid) {
-                    case Volume::LEFT:
-                        volOld = vol.getVolume(Volume::LEFT);
-                        volNew = volLeft;
-                        vol.setVolume(Volume::LEFT, volNew);
-                        break;
-                    case Volume::RIGHT:
-                        volOld = vol.getVolume(Volume::RIGHT);
-                        volNew = volRight;
-                        vol.setVolume(Volume::RIGHT, volNew);
-                        break;
-                    default:
-                        // not supported by OSSv3
-                        break;
-                    }
-
-                    if (volOld != volNew) {
-                        controlChanged = true;
-                        // if ( md->id() == "0" ) qCDebug(KMIX_LOG) << "changed";
-                    }
-                } // for
-            } // muted
+            return Mixer::ERR_READ;
         }
     }
 
-    // --- RECORD SWITCH ---
-    // Volume& captureVol = md->captureVolume();
     int recsrcMask;
     if (ioctl(m_fd, SOUND_MIXER_READ_RECSRC, &recsrcMask) == -1)
-        ret = Mixer::ERR_READ;
-    else {
-        bool isRecsrcOld = md->isRecSource();
-        // test if device bit is set in record bit mask
-        bool isRecsrc = ((recsrcMask & (1 << devnum)) != 0);
-        md->setRecSource(isRecsrc);
-        if (isRecsrcOld != isRecsrc)
+        return Mixer::ERR_READ;
+
+    const bool controlChanged = applyState(md, devnum, volume, recsrcMask);
+    return (controlChanged ? Mixer::OK : Mixer::OK_UNCHANGED);
+}
+
+/**
+ * Sets the state of a control from the level and record sources read
+ * from the mixer.
+ *
+ * @return true if the state of the control has changed
+ */
+bool Mixer_OSS::applyState(shared_ptr<MixDevice> md, int devnum, int volume, int recsrcMask)
+{
+    bool controlChanged = false;
+
+    // --- VOLUME ---
+    Volume &vol = md->playbackVolume();
+    if (vol.hasVolume()) {
+        int volLeft = (volume & 0x7f);
+        int volRight = ((volume >> 8) & 0x7f);
+        //
+        //			if ( md->id() == "0" )
+        //				qCDebug(KMIX_LOG) << md->id() << ": " << "volLeft=" << volLeft << ", volRight" << volRight;
+
+        bool isMuted = volLeft == 0 && (vol.count() < 2 || volRight == 0); // muted is "left and right muted" or "left muted when mono"
+        if (md->isMuted() != isMuted)
             controlChanged = true;
+        md->setMuted(isMuted);
+        if (!isMuted) {
+            // Muted is represented in OSS by value 0. We don't want to write the value 0 as a volume,
+            // but instead we only mark it muted (see setMuted() above).
+
+            for (const VolumeChannel &vc : qAsConst(vol.getVolumes()))
+            {
+                long volOld = 0;
+                long volNew = 0;
+                switch (vc.chid) {
+                case Volume::LEFT:
+                    volOld = vol.getVolume(Volume::LEFT);
+                    volNew = volLeft;
+                    vol.setVolume(Volume::LEFT, volNew);
+                    break;
+                case Volume::RIGHT:
+                    volOld = vol.getVolume(Volume::RIGHT);
+                    volNew = volRight;
+                    vol.setVolume(Volume::RIGHT, volNew);
+                    break;
+                default:
+                    // not supported by OSSv3
+                    break;
+                }
+
+                if (volOld != volNew) {
+                    controlChanged = true;
+                    // if ( md->id() == "0" ) qCDebug(KMIX_LOG) << "changed";
+                }
+            } // for
+        } // muted
     }
 
-    if (ret == 0) {
-        if (controlChanged) {
-            // qCDebug(KMIX_LOG) << "FINE! " << ret;
-            return Mixer::OK;
-        } else {
-            return Mixer::OK_UNCHANGED;
-        }
-    } else {
-        // qCDebug(KMIX_LOG) << "SHIT! " << ret;
-        return ret;
-    }
+    // --- RECORD SWITCH ---
+    bool isRecsrcOld = md->isRecSource();
+    // test if device bit is set in record bit mask
+    bool isRecsrc = ((recsrcMask & (1 << devnum)) != 0);
+    md->setRecSource(isRecsrc);
+    if (isRecsrcOld != isRecsrc)
+        controlChanged = true;
+
+    return controlChanged;
 }
 
 int Mixer_OSS::writeVolumeToHW(const QString &id, shared_ptr<MixDevice> md)
@@ -35,6 +35,7 @@ public:
     QString errorText(int mixer_error) override;
     int readVolumeFromHW(const QString &id, shared_ptr<MixDevice>) override;
     int writeVolumeToHW(const QString &id, shared_ptr<MixDevice>) override;
+    bool hasChangedControls() override;
 
     QString getDriverName() override;
 
@@ -45,10 +46,27 @@ protected:
     virtual QString deviceName(int);
     virtual QString deviceNameDevfs(int);
 
+    void readSetFromHW() override;
+
 private:
     int m_fd;
     QString m_deviceName;
 
+    // The state of the whole mixer, as read in one pass by takeSnapshot()
+    struct Snapshot
+    {
+        int devmask;
+        int recmask;
+        int recsrc;
+        int levels[32]; // one for each bit of the masks
+    };
+    Snapshot m_snapshot;
+    bool m_snapshotValid;   // whether m_snapshot has been taken at all
+    bool m_snapshotCurrent; // whether it was taken for the readSetFromHW() in progress
+
+    bool takeSnapshot(Snapshot *snapshot);
+    bool applyState(shared_ptr<MixDevice> md, int devnum, int volume, int recsrcMask);
+
     int setRecsrcToOSS(const QString &id, bool on);
     void errormsg(int mixer_error);
     int id2num(const QString &id);
@@ -183,7 +183,7 @@ MixDevice::ChannelType Mixer_OSS4::classifyAndRename(QString &name, int flags)
 
 int Mixer_OSS4::open()
 {
-	if ( (m_fd= QT_OPEN("/dev/mixer", O_RDWR)) < 0 )
+	if ( (m_fd= openDevice("/dev/mixer")) < 0 )
 	{
 		if ( errno == EACCES )
 			return Mixer::ERR_PERM;
@@ -195,7 +195,7 @@ int Mixer_OSS4::open()
 	 * Intentionally not wrapped - some systems may not support this ioctl, and therefore
 	 * aren't OSSv4. No need to throw needless error messages at the user in that case.
 	 */
-	if( ::ioctl (m_fd, OSS_GETVERSION, &m_ossVersion) < 0)
+	if( mixerIoctl(OSS_GETVERSION, &m_ossVersion) < 0)
 	{
 		return Mixer::ERR_OPEN;
 	}
@@ -204,7 +204,7 @@ int Mixer_OSS4::open()
 		return Mixer::ERR_OPEN;
 	}
 
-	wrapIoctl( ioctl (m_fd, SNDCTL_MIX_NRMIX, &m_numMixers) );
+	wrapIoctl( mixerIoctl(SNDCTL_MIX_NRMIX, &m_numMixers) );
 
 	if ( m_mixDevices.isEmpty() )
 	{
@@ -221,7 +221,7 @@ int Mixer_OSS4::open()
 			oss_mixerinfo mi;
 
 			mi.dev = m_devnum;
-			if ( wrapIoctl( ioctl (m_fd, SNDCTL_MIXERINFO, &mi) ) < 0 )
+			if ( wrapIoctl( mixerIoctl(SNDCTL_MIXERINFO, &mi) ) < 0 )
 			{
 				return Mixer::ERR_READ;
 			}
@@ -233,12 +233,12 @@ int Mixer_OSS4::open()
 			}
 
 			::close(m_fd);
-			if ( (m_fd= QT_OPEN(mi.devnode, O_RDWR)) < 0 )
+			if ( (m_fd= openDevice(mi.devnode)) < 0 )
 			{
 				return Mixer::ERR_OPEN;
 			}
 
-			if ( wrapIoctl( ioctl (m_fd, SNDCTL_MIX_NREXT, &m_numExtensions) ) < 0 )
+			if ( wrapIoctl( mixerIoctl(SNDCTL_MIX_NREXT, &m_numExtensions) ) < 0 )
 			{
 				//TO DO: more specific error handling here
 				return Mixer::ERR_READ;
@@ -252,7 +252,7 @@ int Mixer_OSS4::open()
 			ext.ctrl = 0;
 
 			//read MIXT_DEVROOT, return Mixer::NODEV on error
-			if ( wrapIoctl ( ioctl( m_fd, SNDCTL_MIX_EXTINFO, &ext) ) < 0 )
+			if ( wrapIoctl ( mixerIoctl(SNDCTL_MIX_EXTINFO, &ext) ) < 0 )
 			{
 				return Mixer::ERR_OPEN;
 			}
@@ -268,7 +268,7 @@ int Mixer_OSS4::open()
 				ext.ctrl = i;
 	
 				//wrapIoctl handles reinitialization, cancel loading on EIDRM
-				if ( wrapIoctl( ioctl( m_fd, SNDCTL_MIX_EXTINFO, &ext) ) == EIDRM )
+				if ( wrapIoctl( mixerIoctl(SNDCTL_MIX_EXTINFO, &ext) ) == EIDRM )
 				{
 					return 0;
 				}
@@ -430,7 +430,7 @@ int Mixer_OSS4::open()
 					ei.dev = m_devnum;
 					ei.ctrl = i;
 
-					if ( wrapIoctl( ioctl (m_fd, SNDCTL_MIX_ENUMINFO, &ei) ) != -1 )
+					if ( wrapIoctl( mixerIoctl(SNDCTL_MIX_ENUMINFO, &ei) ) != -1 )
 					{
 						Volume vol(ext.maxvalue, ext.minvalue,
 									false, isCapture);
@@ -481,6 +481,7 @@ int Mixer_OSS4::close()
 	m_isOpen = false;
 	int l_i_ret = ::close(m_fd);
 	m_recommendedMaster.reset();
+	m_controlValues.clear();
 	closeCommon();
 	return l_i_ret;
 }
@@ -518,7 +519,7 @@ bool Mixer_OSS4::hasChangedControls()
 	oss_mixerinfo minfo;
 
 	minfo.dev = -1;
-	if ( wrapIoctl( ioctl(m_fd, SNDCTL_MIXERINFO, &minfo) ) < 0 )
+	if ( wrapIoctl( mixerIoctl(SNDCTL_MIXERINFO, &minfo) ) < 0 )
 	{
 		qCDebug(KMIX_LOG) << "Can't get mixerinfo from card!\n";
 		return false;
@@ -539,27 +540,29 @@ bool Mixer_OSS4::hasChangedControls()
 int Mixer_OSS4::readVolumeFromHW(const QString& id, shared_ptr<MixDevice> md)
 {
 	oss_mixext extinfo;
-	oss_mixer_value mv;
+	int value;
 
 	extinfo.dev = m_devnum;
 	extinfo.ctrl = id2num(id);
 
-	if ( wrapIoctl( ioctl(m_fd, SNDCTL_MIX_EXTINFO, &extinfo) ) < 0 )
+	if ( wrapIoctl( mixerIoctl(SNDCTL_MIX_EXTINFO, &extinfo) ) < 0 )
 	{
 		//TO DO: more specific error handling
 		return Mixer::ERR_READ;
 	}
 
 	Volume &vol = (CheckCapture (&extinfo)) ? md->captureVolume() : md->playbackVolume();
-	mv.dev = extinfo.dev;
-	mv.ctrl = extinfo.ctrl;
-	mv.timestamp = extinfo.timestamp;
 
-	if ( wrapIoctl ( ioctl (m_fd, SNDCTL_MIX_READ, &mv) ) < 0 )
+	const int ret = readValue(extinfo, &value);
+	if ( ret < 0 )
 	{
 		/* Oops, can't read mixer */
 		return Mixer::ERR_READ;
 	}
+	else if ( ret == 0 )
+	{
+		return Mixer::OK_UNCHANGED;
+	}
 	else
 	{
 		if ( md->isMuted() && extinfo.type != MIXT_ONOFF )
@@ -573,29 +576,29 @@ int Mixer_OSS4::readVolumeFromHW(const QString& id, shared_ptr<MixDevice> md)
 			case MIXT_MUTE:
 #endif			  
 			case MIXT_ONOFF:
-				md->setMuted(mv.value != extinfo.minvalue);
+				md->setMuted(value != extinfo.minvalue);
 				break;
 
 			case MIXT_MONOSLIDER:
-				vol.setVolume(Volume::LEFT, mv.value & 0xff);
+				vol.setVolume(Volume::LEFT, value & 0xff);
 				break;
 
 			case MIXT_STEREOSLIDER:
-				vol.setVolume(Volume::LEFT, mv.value & 0xff);
-				vol.setVolume(Volume::RIGHT, ( mv.value >> 8 ) & 0xff);
+				vol.setVolume(Volume::LEFT, value & 0xff);
+				vol.setVolume(Volume::RIGHT, ( value >> 8 ) & 0xff);
 				break;
 
 			case MIXT_SLIDER:
-				vol.setVolume(Volume::LEFT, mv.value);
+				vol.setVolume(Volume::LEFT, value);
 				break;
 
 			case MIXT_MONOSLIDER16:
-				vol.setVolume(Volume::LEFT, mv.value & 0xffff);
+				vol.setVolume(Volume::LEFT, value & 0xffff);
 				break;
 
 			case MIXT_STEREOSLIDER16:
-				vol.setVolume(Volume::LEFT, mv.value & 0xffff);
-				vol.setVolume(Volume::RIGHT, ( mv.value >> 16 ) & 0xffff);
+				vol.setVolume(Volume::LEFT, value & 0xffff);
+				vol.setVolume(Volume::RIGHT, ( value >> 16 ) & 0xffff);
 				break;
 		}
 	}
@@ -612,7 +615,7 @@ int Mixer_OSS4::writeVolumeToHW(const QString& id, shared_ptr<MixDevice> md)
 	extinfo.dev = m_devnum;
 	extinfo.ctrl = id2num(id);
 
-	if ( wrapIoctl( ioctl(m_fd, SNDCTL_MIX_EXTINFO, &extinfo) ) < 0 )
+	if ( wrapIoctl( mixerIoctl(SNDCTL_MIX_EXTINFO, &extinfo) ) < 0 )
 	{
 		//TO DO: more specific error handling
 		qCDebug(KMIX_LOG) << "failed to read info for control " << id2num(id);
@@ -658,7 +661,10 @@ int Mixer_OSS4::writeVolumeToHW(const QString& id, shared_ptr<MixDevice> md)
 	mv.timestamp = extinfo.timestamp;
 	mv.value = volume - extinfo.minvalue;
 
-	if ( wrapIoctl ( ioctl (m_fd, SNDCTL_MIX_WRITE, &mv) ) < 0 )
+	// Read it back next time even if the write fails, e.g. because of an exclusive capture group
+	m_controlValues.remove(extinfo.ctrl);
+
+	if ( wrapIoctl ( mixerIoctl(SNDCTL_MIX_WRITE, &mv) ) < 0 )
 	{
 		qCDebug(KMIX_LOG) << "error writing to control" << extinfo.extname;
 		return Mixer::ERR_WRITE;
@@ -674,7 +680,7 @@ void Mixer_OSS4::setEnumIdHW(const QString& id, unsigned int idx)
 	extinfo.dev = m_devnum;
 	extinfo.ctrl = id2num(id);
 
-	if ( wrapIoctl ( ioctl(m_fd, SNDCTL_MIX_EXTINFO, &extinfo) ) < 0 )
+	if ( wrapIoctl ( mixerIoctl(SNDCTL_MIX_EXTINFO, &extinfo) ) < 0 )
 	{
 		//TO DO: more specific error handling
 		qCDebug(KMIX_LOG) << "failed to read info for control " << id2num(id);
@@ -707,7 +713,9 @@ void Mixer_OSS4::setEnumIdHW(const QString& id, unsigned int idx)
 	mv.timestamp = extinfo.timestamp;
 	mv.value = idx;
 
-	if ( wrapIoctl ( ioctl (m_fd, SNDCTL_MIX_WRITE, &mv) ) < 0 )
+	m_controlValues.remove(extinfo.ctrl);
+
+	if ( wrapIoctl ( mixerIoctl(SNDCTL_MIX_WRITE, &mv) ) < 0 )
 	{
 		/* Oops, can't write to mixer */
 		qCDebug(KMIX_LOG) << "error writing to control" << extinfo.extname;
@@ -722,7 +730,7 @@ unsigned int Mixer_OSS4::enumIdHW(const QString& id)
 	extinfo.dev = m_devnum;
 	extinfo.ctrl = id2num(id);
 
-	if ( wrapIoctl ( ioctl(m_fd, SNDCTL_MIX_EXTINFO, &extinfo) ) < 0 )
+	if ( wrapIoctl ( mixerIoctl(SNDCTL_MIX_EXTINFO, &extinfo) ) < 0 )
 	{
 		//TO DO: more specific error handling
 		//TO DO: check whether those return values are actually possible
@@ -734,16 +742,60 @@ unsigned int Mixer_OSS4::enumIdHW(const QString& id)
 		return Mixer::ERR_READ;
 	}
 
+	// Usually already read by readVolumeFromHW() just before
+	int value;
+	if ( readValue(extinfo, &value) < 0 )
+	{
+		/* Oops, can't read mixer */
+		return Mixer::ERR_READ;
+	}
+	return value;
+}
+
+/**
+ * Reads the value of a control, unless its update counter shows that it
+ * has not changed since it was last read.  Then only the SNDCTL_MIX_EXTINFO
+ * that returned @p extinfo is needed to check a control, not also a
+ * SNDCTL_MIX_READ.  A driver which does not maintain the update counter
+ * leaves it at 0, so such controls are always read.
+ *
+ * @return 1 if the value was read, 0 if it is unchanged (and @p value is
+ *         the last value read), or -1 if it could not be read
+ */
+int Mixer_OSS4::readValue(const oss_mixext &extinfo, int *value)
+{
+	QHash<int,ControlValue>::const_iterator it = m_controlValues.constFind(extinfo.ctrl);
+	if ( extinfo.update_counter != 0 && it != m_controlValues.constEnd() &&
+	     it->updateCounter == extinfo.update_counter )
+	{
+		*value = it->value;
+		return 0;
+	}
+
+	oss_mixer_value mv;
 	mv.dev = extinfo.dev;
 	mv.ctrl = extinfo.ctrl;
 	mv.timestamp = extinfo.timestamp;
 
-	if ( wrapIoctl ( ioctl (m_fd, SNDCTL_MIX_READ, &mv) ) < 0 )
+	if ( wrapIoctl ( mixerIoctl(SNDCTL_MIX_READ, &mv) ) < 0 )
 	{
-		/* Oops, can't read mixer */
-		return Mixer::ERR_READ;
+		m_controlValues.remove(extinfo.ctrl);
+		return -1;
 	}
-	return mv.value;
+
+	m_controlValues.insert(extinfo.ctrl, ControlValue { extinfo.update_counter, mv.value });
+	*value = mv.value;
+	return 1;
+}
+
+int Mixer_OSS4::openDevice(const char *path)
+{
+	return QT_OPEN(path, O_RDWR);
+}
+
+int Mixer_OSS4::mixerIoctl(unsigned long request, void *arg)
+{
+	return ::ioctl(m_fd, request, arg);
 }
 
 int Mixer_OSS4::wrapIoctl(int ioctlRet)
@@ -25,6 +25,8 @@
 #include "mixer_backend.h"
 #include <sys/soundcard.h>
 
+#include <QHash>
+
 class Mixer_OSS4 : public Mixer_Backend
 {
 public:
@@ -45,6 +47,11 @@ protected:
   MixDevice::ChannelType classifyAndRename(QString &name, int flags);
 
   int wrapIoctl(int ioctlRet);
+  // All access to the device goes through these two, so that a
+  // simulated mixer can be used instead (see tests/oss4bench.cpp)
+  virtual int openDevice(const char *path);
+  virtual int mixerIoctl(unsigned long request, void *arg);
+  int readValue(const oss_mixext &extinfo, int *value);
 
   void reinitialize() { open(); close(); }
   virtual int open();
@@ -57,6 +64,14 @@ protected:
   int	  m_modifyCounter;
   QString m_deviceName;
 
+  // The value of each control when it was last read, and its update counter then
+  struct ControlValue
+  {
+    int updateCounter;
+    int value;
+  };
+  QHash<int,ControlValue> m_controlValues;
+
 private:
   int id2num(const QString& id);
 };
@@ -23,12 +23,18 @@
 
 #include "qtpamainloop.h"
 
+#include <QSet>
 #include <QStringBuilder>
+#include <QTimer>
+#include <QVector>
 
 #include <klocalizedstring.h>
 
 #include "core/mixer.h"
 #include "core/ControlManager.h"
+#include "core/backendrecorder.h"
+#include "core/kmixstats.h"
+#include "core/kmixtrace.h"
 #include "settings.h"
 
 #include <pulse/ext-stream-restore.h>
@@ -71,6 +77,12 @@ typedef struct {
 } restoreRule;
 static QMap<QString,restoreRule> s_RestoreRules;
 
+// State of the stream restore database read that is in progress
+static QSet<QString> s_restoreRulesSeen;
+static QSet<QString> s_restoreRulesChanged;
+static bool s_restoreReadActive = false;
+static bool s_restoreReadAgain = false;
+
 static void dec_outstanding(pa_context *c) {
     if (s_outstandingRequests <= 0)
         return;
@@ -181,6 +193,92 @@ static QString getIconNameFromProplist(pa_proplist *l) {
     return "";
 }
 
+/**
+ * Rules for streams that are never shown, as configured by the
+ * "PulseIgnore..." settings.  The strings are converted once when
+ * the rules are loaded, so that classifyStream() can match them
+ * against the raw property list without any Qt string conversion.
+ */
+typedef struct {
+    bool ignoreEvents;
+    bool ignorePeaks;
+    QList<QByteArray> roles;
+    QList<QByteArray> applications;
+} streamFilter;
+static streamFilter s_streamFilter;
+
+enum StreamClass { StreamShow, StreamIgnore };
+
+static void loadStreamFilter()
+{
+    s_streamFilter.ignoreEvents = Settings::pulseIgnoreEventStreams();
+    s_streamFilter.ignorePeaks = Settings::pulseIgnorePeakStreams();
+
+    s_streamFilter.roles.clear();
+    const QStringList roles = Settings::pulseIgnoreRoles();
+    for (const QString &role : roles) s_streamFilter.roles.append(role.toUtf8());
+
+    s_streamFilter.applications.clear();
+    const QStringList apps = Settings::pulseIgnoreApplications();
+    for (const QString &app : apps) s_streamFilter.applications.append(app.toUtf8());
+}
+
+static bool matchesAny(const char *value, const QList<QByteArray> &list)
+{
+    if (value==nullptr) return (false);
+    for (const QByteArray &item : list)
+    {
+        if (item==value) return (true);
+    }
+    return (false);
+}
+
+/**
+ * Decide whether a stream is to be shown, using only the raw information
+ * supplied by PulseAudio.  This is called before anything is allocated
+ * for the stream, so that streams which would never be shown (peak meters,
+ * event sounds, or anything matching the configured rules) cost as little
+ * as possible.
+ *
+ * A stream that is ignored is not remembered, so it will be classified
+ * again on its next change notification and will appear then if it no
+ * longer matches.
+ *
+ * @param props The stream property list
+ * @param map The stream channel map
+ * @param resampleMethod The stream resample method, may be @c nullptr
+ * @return the classification of the stream
+ */
+static StreamClass classifyStream(const pa_proplist *props, const pa_channel_map &map,
+                                  const char *resampleMethod)
+{
+    // A stream without usable channels cannot become a control,
+    // see translateMasksAndMaps() and Mixer_PULSE::addDevice().
+    if (map.channels==0) return (StreamIgnore);
+
+    // Level meters record with peak detection, which PulseAudio
+    // reports as a special resample method.
+    if (s_streamFilter.ignorePeaks && resampleMethod!=nullptr && strcmp(resampleMethod, "peaks")==0)
+        return (StreamIgnore);
+
+    // Event sounds are handled by the "Event Sounds" slider.
+    const char *t = pa_proplist_gets(props, "module-stream-restore.id");
+    if (s_streamFilter.ignoreEvents && t!=nullptr && strcmp(t, KMIXPA_EVENT_KEY)==0)
+        return (StreamIgnore);
+
+    if (matchesAny(pa_proplist_gets(props, PA_PROP_MEDIA_ROLE), s_streamFilter.roles))
+        return (StreamIgnore);
+
+    if (!s_streamFilter.applications.isEmpty())
+    {
+        if (matchesAny(pa_proplist_gets(props, PA_PROP_APPLICATION_ID), s_streamFilter.applications) ||
+            matchesAny(pa_proplist_gets(props, PA_PROP_APPLICATION_PROCESS_BINARY), s_streamFilter.applications))
+            return (StreamIgnore);
+    }
+
+    return (StreamShow);
+}
+
 static void sink_cb(pa_context *c, const pa_sink_info *i, int eol, void *) {
 
     if (eol < 0) {
@@ -222,6 +320,8 @@ static void sink_cb(pa_context *c, const pa_sink_info *i, int eol, void *) {
         if (is_new)
             s_mixers[KMIXPA_PLAYBACK]->addWidget(s.index);
         else {
+            // This is the echo of any change to the device, by us or others
+            s_mixers[KMIXPA_PLAYBACK]->writeConfirmed(s.name);
             int mid = s_mixers[KMIXPA_PLAYBACK]->id2num(s.name);
             if (mid >= 0) {
                 MixSet *ms = s_mixers[KMIXPA_PLAYBACK]->getMixSet();
@@ -275,6 +375,7 @@ static void source_cb(pa_context *c, const pa_source_info *i, int eol, void *) {
         if (is_new)
             s_mixers[KMIXPA_CAPTURE]->addWidget(s.index);
         else {
+            s_mixers[KMIXPA_CAPTURE]->writeConfirmed(s.name);
             int mid = s_mixers[KMIXPA_CAPTURE]->id2num(s.name);
             if (mid >= 0) {
                 MixSet *ms = s_mixers[KMIXPA_CAPTURE]->getMixSet();
@@ -320,14 +421,16 @@ static void sink_input_cb(pa_context *c, const pa_sink_input_info *i, int eol, v
         return;
     }
 
-    const char *t;
-    if ((t = pa_proplist_gets(i->proplist, "module-stream-restore.id"))) {
-        if (strcmp(t, KMIXPA_EVENT_KEY) == 0) {
-            //qCDebug(KMIX_LOG) << "Ignoring sink-input due to it being designated as an event and thus handled by the Event slider";
-            return;
-        }
+    if (classifyStream(i->proplist, i->channel_map, i->resample_method)==StreamIgnore)
+    {
+        // The stream may have been shown before its properties changed
+        if (outputStreams.contains(i->index) && s_mixers.contains(KMIXPA_APP_PLAYBACK))
+            s_mixers[KMIXPA_APP_PLAYBACK]->removeWidget(i->index);
+        return;
     }
 
+    const char *t = pa_proplist_gets(i->proplist, "module-stream-restore.id");
+
     QString appname = i18n("Unknown Application");
     if (clients.contains(i->client))
         appname = clients.value(i->client);
@@ -353,6 +456,7 @@ static void sink_input_cb(pa_context *c, const pa_sink_input_info *i, int eol, v
         if (is_new)
             s_mixers[KMIXPA_APP_PLAYBACK]->addWidget(s.index, true);
         else {
+            s_mixers[KMIXPA_APP_PLAYBACK]->writeConfirmed(s.name);
             int mid = s_mixers[KMIXPA_APP_PLAYBACK]->id2num(s.name);
             if (mid >= 0) {
                 MixSet *ms = s_mixers[KMIXPA_APP_PLAYBACK]->getMixSet();
@@ -385,6 +489,14 @@ static void source_output_cb(pa_context *c, const pa_source_output_info *i, int
         return;
     }
 
+    if (classifyStream(i->proplist, i->channel_map, i->resample_method)==StreamIgnore)
+    {
+        // The stream may have been shown before its properties changed
+        if (captureStreams.contains(i->index) && s_mixers.contains(KMIXPA_APP_CAPTURE))
+            s_mixers[KMIXPA_APP_CAPTURE]->removeWidget(i->index);
+        return;
+    }
+
     QString appname = i18n("Unknown Application");
     if (clients.contains(i->client))
         appname = clients.value(i->client);
@@ -415,6 +527,7 @@ static void source_output_cb(pa_context *c, const pa_source_output_info *i, int
         if (is_new)
             s_mixers[KMIXPA_APP_CAPTURE]->addWidget(s.index, true);
         else {
+            s_mixers[KMIXPA_APP_CAPTURE]->writeConfirmed(s.name);
             int mid = s_mixers[KMIXPA_APP_CAPTURE]->id2num(s.name);
             if (mid >= 0) {
                 MixSet *ms = s_mixers[KMIXPA_APP_CAPTURE]->getMixSet();
@@ -471,8 +584,10 @@ static int doForDevice(const QString &id, const devmap *devices, shared_ptr<MixD
  */
 static bool checkOpResult(pa_operation *op, const char *explain)
 {
+    KMixStats::count(KMixStats::PulseOperations);
     if (op==nullptr)
     {
+        KMixStats::count(KMixStats::PulseOperationsFailed);
         qCWarning(KMIX_LOG) << "PulseAudio operation" << explain << "failed,"
                             << pa_strerror(pa_context_errno(s_context));
         return (false);
@@ -483,17 +598,62 @@ static bool checkOpResult(pa_operation *op, const char *explain)
 }
 
 
+/**
+ * Compare two restore rules, returning @c true if they are the same.
+ * Used to find out which rules have actually changed when the stream
+ * restore database is read again.
+ */
+static bool sameRestoreRule(const restoreRule &a, const restoreRule &b)
+{
+    // The volume and channel map are optional in a rule, so they may be
+    // empty.  The PulseAudio comparison functions complain about that, so
+    // compare them here directly.
+    if (a.mute!=b.mute) return (false);
+    if (a.channel_map.channels!=b.channel_map.channels) return (false);
+    for (uint8_t i = 0; i<a.channel_map.channels; ++i)
+    {
+        if (a.channel_map.map[i]!=b.channel_map.map[i]) return (false);
+    }
+    if (a.volume.channels!=b.volume.channels) return (false);
+    for (uint8_t i = 0; i<a.volume.channels; ++i)
+    {
+        if (a.volume.values[i]!=b.volume.values[i]) return (false);
+    }
+    return (a.device==b.device);
+}
+
+static void start_restore_read(pa_context *c);
+
 void ext_stream_restore_read_cb(pa_context *c, const pa_ext_stream_restore_info *i, int eol, void *)
 {
     if (eol < 0) {
         dec_outstanding(c);
         qCWarning(KMIX_LOG) << "Failed to initialize stream_restore extension," << pa_strerror(pa_context_errno(s_context));
+        s_restoreRulesSeen.clear();
+        s_restoreRulesChanged.clear();
+        s_restoreReadActive = false;
+
+        // As below, a change notified during the failed read is not lost
+        if (s_restoreReadAgain) start_restore_read(c);
         return;
     }
 
     if (eol > 0) {
         dec_outstanding(c);
 
+        // The database does not report deletions explicitly, so any
+        // rule that was not seen during this read has gone away.  The
+        // rule for our media events is kept, as we always need one.
+        for (QMap<QString,restoreRule>::iterator it = s_RestoreRules.begin(); it!=s_RestoreRules.end(); )
+        {
+            if (!s_restoreRulesSeen.contains(it.key()) && it.key()!=KMIXPA_EVENT_KEY)
+            {
+                s_restoreRulesChanged.insert(it.key());
+                it = s_RestoreRules.erase(it);
+            }
+            else ++it;
+        }
+
         // Special case: ensure that our media events exists.
         // On first login by a new user this won't be in our
         // database, so we should create it.
@@ -507,27 +667,41 @@ void ext_stream_restore_read_cb(pa_context *c, const pa_ext_stream_restore_info
             rule.mute = false;
             rule.device = "";
             s_RestoreRules[KMIXPA_EVENT_KEY] = rule;
+            s_restoreRulesChanged.insert(KMIXPA_EVENT_KEY);
             qCDebug(KMIX_LOG) << "Initializing restore rule for 'Event Sounds'";
         }
 
+        // Only the roles that are shown need any further action, and
+        // then only if they are new or have changed.  We only want to
+        // know about Sound Events for now...
         if (s_mixers.contains(KMIXPA_APP_PLAYBACK)) {
-            // If we have rules, it will be created below... but if no rules
-            // then we add it here.
             if (!outputRoles.contains(PA_INVALID_INDEX)) {
                 devinfo s = create_role_devinfo(KMIXPA_EVENT_KEY);
                 outputRoles[s.index] = s;
 
-                s_mixers[KMIXPA_APP_PLAYBACK]->addWidget(s.index);
+                s_mixers[KMIXPA_APP_PLAYBACK]->addWidget(s.index, true);
             }
+            else if (s_restoreRulesChanged.contains(KMIXPA_EVENT_KEY)) {
+                devinfo s = create_role_devinfo(KMIXPA_EVENT_KEY);
+                outputRoles[s.index] = s;
 
-            s_mixers[KMIXPA_APP_PLAYBACK]->triggerUpdate();
+                s_mixers[KMIXPA_APP_PLAYBACK]->updateRoleWidget(s.name);
+            }
         }
 
+        s_restoreRulesSeen.clear();
+        s_restoreRulesChanged.clear();
+        s_restoreReadActive = false;
+
+        // More changes were notified while this read was in progress
+        if (s_restoreReadAgain) start_restore_read(c);
         return;
     }
 
     QString name = QString::fromUtf8(i->name);
 //     qCDebug(KMIX_LOG) << QString("Got some info about restore rule: '%1' (Device: %2)").arg(name).arg(i->device ? i->device : "None");
+    s_restoreRulesSeen.insert(name);
+
     restoreRule rule;
     rule.channel_map = i->channel_map;
     rule.volume = i->volume;
@@ -543,33 +717,47 @@ void ext_stream_restore_read_cb(pa_context *c, const pa_ext_stream_restore_info
         rule.volume.values[0] = PA_VOLUME_NORM;
     }
 
-    s_RestoreRules[name] = rule;
+    QMap<QString,restoreRule>::const_iterator it = s_RestoreRules.constFind(name);
+    if (it!=s_RestoreRules.constEnd() && sameRestoreRule(*it, rule)) return;
 
-    if (s_mixers.contains(KMIXPA_APP_PLAYBACK)) {
-        // We only want to know about Sound Events for now...
-        if (name == KMIXPA_EVENT_KEY) {
-            devinfo s = create_role_devinfo(name);
-            bool is_new = !outputRoles.contains(s.index);
-            outputRoles[s.index] = s;
+    s_RestoreRules[name] = rule;
+    s_restoreRulesChanged.insert(name);
+}
 
-            if (is_new)
-                s_mixers[KMIXPA_APP_PLAYBACK]->addWidget(s.index, true);
-        }
+/**
+ * Start reading the stream restore database, unless a read is already
+ * in progress.  In that case the read is repeated once the current one
+ * has finished, so that a burst of change notifications results in at
+ * most two reads.
+ */
+static void start_restore_read(pa_context *c)
+{
+    if (s_restoreReadActive)
+    {
+        s_restoreReadAgain = true;
+        return;
     }
+
+    s_restoreReadAgain = false;
+    pa_operation *op = pa_ext_stream_restore_read(c, ext_stream_restore_read_cb, NULL);
+    if (checkOpResult(op, "pa_ext_stream_restore_read")) s_restoreReadActive = true;
 }
 
 static void ext_stream_restore_subscribe_cb(pa_context *c, void *)
 {
     Q_ASSERT(c == s_context);
-
-    pa_operation *op = pa_ext_stream_restore_read(c, ext_stream_restore_read_cb, NULL);
-    checkOpResult(op, "pa_ext_stream_restore_read");
+    start_restore_read(c);
 }
 
 
 static void subscribe_cb(pa_context *c, pa_subscription_event_type_t t, uint32_t index, void *)
 {
     Q_ASSERT(c == s_context);
+    KMixTrace::Span span("subscribe", "backend");
+    if (BackendRecorder::isRecording())
+    {
+        BackendRecorder::recordEvent(QString(), QString("subscribe 0x%1 %2").arg(static_cast<uint>(t), 0, 16).arg(index));
+    }
 
     switch (t & PA_SUBSCRIPTION_EVENT_FACILITY_MASK)
     {
@@ -624,6 +812,31 @@ static void subscribe_cb(pa_context *c, pa_subscription_event_type_t t, uint32_t
     }
 }
 
+/**
+ * Load the stream filter again after the settings have changed.  If it
+ * is different, the streams are listed again, so that those which are
+ * now ignored are removed and those which are no longer ignored appear.
+ */
+static void reloadStreamFilter()
+{
+    const streamFilter old = s_streamFilter;
+    loadStreamFilter();
+    if (s_streamFilter.ignoreEvents==old.ignoreEvents &&
+        s_streamFilter.ignorePeaks==old.ignorePeaks &&
+        s_streamFilter.roles==old.roles &&
+        s_streamFilter.applications==old.applications) return;
+
+    if (s_context==nullptr || pa_context_get_state(s_context)!=PA_CONTEXT_READY) return;
+    qCDebug(KMIX_LOG) << "Stream filter changed, listing the streams again";
+
+    // As for a change notification, these are not outstanding requests
+    pa_operation *op = pa_context_get_sink_input_info_list(s_context, sink_input_cb, NULL);
+    checkOpResult(op, "pa_context_get_sink_input_info_list");
+
+    op = pa_context_get_source_output_info_list(s_context, source_output_cb, NULL);
+    checkOpResult(op, "pa_context_get_source_output_info_list");
+}
+
 
 static void context_state_callback(pa_context *c, void *)
 {
@@ -632,6 +845,9 @@ static void context_state_callback(pa_context *c, void *)
         // Attempt to load things up
         pa_operation *op;
 
+        // 0. Pick up the current stream filter rules, before any stream info arrives
+        loadStreamFilter();
+
         // 1. Register for the stream changes (except during probe)
         if (s_context == c) {
             pa_context_set_subscribe_callback(c, subscribe_cb, NULL);
@@ -670,6 +886,7 @@ static void context_state_callback(pa_context *c, void *)
         if (checkOpResult(op, "pa_ext_stream_restore_read"))
         {
             s_outstandingRequests++;
+            if (s_context == c) s_restoreReadActive = true;
 
             pa_ext_stream_restore_set_subscribe_cb(c, ext_stream_restore_subscribe_cb, NULL);
             pa_ext_stream_restore_subscribe(c, 1, NULL, NULL);
@@ -689,6 +906,9 @@ static void context_state_callback(pa_context *c, void *)
             }
             // This one is not handled above.
             clients.clear();
+            s_restoreRulesSeen.clear();
+            s_restoreRulesChanged.clear();
+            s_restoreReadActive = s_restoreReadAgain = false;
 
             if (s_mixers.contains(KMIXPA_PLAYBACK)) {
                 qCWarning(KMIX_LOG) << "Connection to PulseAudio daemon closed. Attempting reconnection.";
@@ -837,6 +1057,23 @@ void Mixer_PULSE::addWidget(int index, bool isAppStream)
     emitControlsReconfigured();
 }
 
+/**
+ * Refresh the control for a stream restore role, after its rule has
+ * changed.  Only this control is read, and the change is announced
+ * without rereading any of the other controls of this mixer.
+ */
+void Mixer_PULSE::updateRoleWidget(const QString &id)
+{
+    if (_mixer==nullptr) return;			// the Mixer has been deleted
+    const int mid = id2num(id);
+    if (mid<0) return;
+
+    shared_ptr<MixDevice> md = m_mixDevices[mid];
+    readVolumeFromHW(id, md);
+    writeConfirmed(id);
+    ControlManager::instance().announce(_mixer->id(), ControlManager::Volume, QString("Mixer_PULSE.updateRoleWidget()"));
+}
+
 void Mixer_PULSE::removeWidget(int index)
 {
     devmap* map = get_widget_map(m_devnum);
@@ -850,6 +1087,7 @@ void Mixer_PULSE::removeWidget(int index)
 
     QString id = (*map)[index].name;
     map->remove(index);
+    if (_mixer!=nullptr) KMixStats::writesDropped(_mixer->id(), id);
 
     // We need to find the MixDevice that goes with this widget and remove it.
     MixSet::iterator iter;
@@ -860,8 +1098,6 @@ void Mixer_PULSE::removeWidget(int index)
         {
             md = m_mixDevices.get(id);
             qCDebug(KMIX_LOG) << "MixDevice 1 useCount=" << md.use_count();
-            md->close();
-            qCDebug(KMIX_LOG) << "MixDevice 2 useCount=" << md.use_count();
             m_mixDevices.erase(iter);
             qCDebug(KMIX_LOG) << "MixDevice 3 useCount=" << md.use_count();
             break;
@@ -972,6 +1208,12 @@ Mixer_PULSE::Mixer_PULSE(Mixer *mixer, int devnum) : Mixer_Backend(mixer, devnum
     if (pulseenv.toInt())
         s_pulseActive = INACTIVE;
 
+    // Only one of the mixers needs to follow the stream filter settings
+    if (m_devnum==KMIXPA_APP_PLAYBACK)
+    {
+        connect(Settings::self(), &KCoreConfigSkeleton::configChanged, this, []() { reloadStreamFilter(); });
+    }
+
     ++refcount;
     if (INACTIVE != s_pulseActive && 1 == refcount)
     {
@@ -1240,6 +1482,74 @@ default:
 }
 
 
+/**
+ * Write a number of controls.  The stream restore roles are all written
+ * with a single request to the stream restore extension, and the other
+ * controls are written one after the other as usual.  The requests are
+ * only sent when the main loop next runs, so they all reach the server
+ * together anyway.
+ */
+QList<int> Mixer_PULSE::writeVolumesToHW(const QList<shared_ptr<MixDevice> > &mds)
+{
+    if (m_devnum!=KMIXPA_APP_PLAYBACK) return (Mixer_Backend::writeVolumesToHW(mds));
+
+    QList<int> results;
+    QVector<pa_ext_stream_restore_info> infos;
+    QList<QByteArray> names;				// keep the strings for the infos
+    QList<QByteArray> devices;
+    QList<int> roleResults;				// indexes into results
+
+    for (const shared_ptr<MixDevice> &md : mds)
+    {
+        const QString id = md->id();
+        if (!id.startsWith(QLatin1String("restore:")))
+        {
+            results.append(writeVolumeToHW(id, md));
+            continue;
+        }
+
+        const devinfo *dev = nullptr;
+        for (devmap::const_iterator iter = outputRoles.constBegin(); iter!=outputRoles.constEnd(); ++iter)
+        {
+            if (iter->name==id) dev = &*iter;
+        }
+
+        if (dev==nullptr)
+        {
+            qCDebug(KMIX_LOG) << "Device" << id << "not in map";
+            results.append(Mixer::OK);
+            continue;
+        }
+
+        const restoreRule &rule = s_RestoreRules[dev->stream_restore_rule];
+        names.append(dev->stream_restore_rule.toUtf8());
+        devices.append(rule.device.toUtf8());
+
+        pa_ext_stream_restore_info info;
+        info.name = names.last().constData();
+        info.channel_map = rule.channel_map;
+        info.volume = genVolumeForPulse(*dev, md->playbackVolume());
+        info.device = devices.last().isEmpty() ? NULL : devices.last().constData();
+        info.mute = (md->isMuted() ? 1 : 0);
+        infos.append(info);
+
+        roleResults.append(results.count());
+        results.append(Mixer::OK);
+    }
+
+    if (!infos.isEmpty())
+    {
+        pa_operation *op = pa_ext_stream_restore_write(s_context, PA_UPDATE_REPLACE, infos.constData(), infos.count(), true, NULL, NULL);
+        if (!checkOpResult(op, "pa_ext_stream_restore_write"))
+        {
+            for (int idx : qAsConst(roleResults)) results[idx] = Mixer::ERR_WRITE;
+        }
+    }
+
+    return (results);
+}
+
+
 static const devinfo *getStreamInfo(int devnum, const QString &id)
 {
     //qCDebug(KMIX_LOG) <<  "dev" << devnum << "id" << id;
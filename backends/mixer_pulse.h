@@ -55,6 +55,7 @@ class Mixer_PULSE : public Mixer_Backend
 
         int readVolumeFromHW( const QString& id, shared_ptr<MixDevice> ) override;
         int writeVolumeToHW ( const QString& id, shared_ptr<MixDevice> ) override;
+        QList<int> writeVolumesToHW(const QList<shared_ptr<MixDevice> > &mds) override;
 
         QString currentStreamDevice(const QString &id) const override;
         bool moveStream( const QString& id, const QString& destId ) override;
@@ -63,15 +64,18 @@ class Mixer_PULSE : public Mixer_Backend
         QString getId() const override { return _id; }
 
         bool needsPolling() override { return false; }
+        bool confirmsWrites() const override { return true; }
 
         // Only used internally, but need to be able to be called by
         // static PulseAudio callback functions.
         void triggerUpdate();
         void addWidget(int index, bool = false);
         void removeWidget(int index);
+        void updateRoleWidget(const QString &id);
         void removeAllWidgets();
         MixSet *getMixSet() { return &m_mixDevices; }
         int id2num(const QString& id);
+        using Mixer_Backend::writeConfirmed;
 
     protected:
         int open() override;
@@ -0,0 +1,408 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "backends/mixer_replay.h"
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
+
+#include "core/ControlManager.h"
+#include "core/kmixtrace.h"
+#include "core/mixer.h"
+#include "core/topologycache.h"
+#include "kmix_debug.h"
+
+
+struct ReplayRecord
+{
+	quint8 type;
+	qint64 usecs;
+	QString mixerId;
+	QByteArray payload;
+};
+
+
+/**
+ * Plays back the loaded recording to the Replay mixers, once the first
+ * of them has been opened.
+ */
+class ReplayPlayer
+{
+	public:
+		static ReplayPlayer *instance()			{ return (s_instance); }
+		static bool load(const QString &fileName, double speed);
+
+		const QStringList &mixerIds() const		{ return (m_mixerIds); }
+		/// The topology that the mixer is opened with
+		QByteArray firstTopology(const QString &mixerId) const;
+
+		void attach(Mixer_Replay *backend);
+		void detach(Mixer_Replay *backend);
+
+	private:
+		ReplayPlayer(double speed);
+
+		void playNext();
+		void schedule();
+
+		static ReplayPlayer *s_instance;
+
+		QList<ReplayRecord> m_records;
+		QStringList m_mixerIds;			// in the order that they were first seen
+		QHash<QString,int> m_firstTopology;	// mixer ID to record index
+		QHash<QString,Mixer_Replay *> m_backends;
+		double m_speed;
+		int m_next;
+		bool m_started;
+		QTimer m_timer;
+		QElapsedTimer m_clock;
+};
+
+ReplayPlayer *ReplayPlayer::s_instance = nullptr;
+
+
+ReplayPlayer::ReplayPlayer(double speed)
+	: m_speed(speed),
+	  m_next(0),
+	  m_started(false)
+{
+	m_timer.setSingleShot(true);
+	m_timer.setTimerType(Qt::PreciseTimer);
+	QObject::connect(&m_timer, &QTimer::timeout, [this]() { playNext(); });
+}
+
+
+bool ReplayPlayer::load(const QString &fileName, double speed)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qCWarning(KMIX_LOG) << "Cannot read recording" << fileName << file.errorString();
+		return (false);
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_6);
+
+	quint32 magic, version;
+	stream >> magic >> version;
+	if (stream.status()!=QDataStream::Ok || magic!=BackendRecorder::fileMagic || version!=BackendRecorder::fileVersion)
+	{
+		qCWarning(KMIX_LOG) << fileName << "is not a recording of this version";
+		return (false);
+	}
+
+	ReplayPlayer *player = new ReplayPlayer(speed);
+	while (!stream.atEnd())
+	{
+		ReplayRecord record;
+		stream >> record.type >> record.usecs >> record.mixerId >> record.payload;
+		if (stream.status()!=QDataStream::Ok)
+		{
+			// Probably cut short, play what there is
+			qCWarning(KMIX_LOG) << "Recording" << fileName << "is truncated";
+			break;
+		}
+
+		if (record.type==BackendRecorder::Topology && !player->m_firstTopology.contains(record.mixerId))
+		{
+			player->m_mixerIds.append(record.mixerId);
+			player->m_firstTopology.insert(record.mixerId, player->m_records.count());
+		}
+		player->m_records.append(record);
+	}
+
+	qCDebug(KMIX_LOG) << "Loaded" << player->m_records.count() << "records of"
+			  << player->m_mixerIds.count() << "mixers from" << fileName;
+	delete s_instance;
+	s_instance = player;
+	return (true);
+}
+
+
+QByteArray ReplayPlayer::firstTopology(const QString &mixerId) const
+{
+	const int index = m_firstTopology.value(mixerId, -1);
+	return (index<0 ? QByteArray() : m_records.at(index).payload);
+}
+
+
+void ReplayPlayer::attach(Mixer_Replay *backend)
+{
+	m_backends.insert(backend->m_recordedId, backend);
+	if (m_started) return;
+
+	// All of the mixers are opened together, so start after that
+	m_started = true;
+	QTimer::singleShot(0, [this]()
+	{
+		qCDebug(KMIX_LOG) << "Replay started";
+		m_clock.start();
+		schedule();
+	});
+}
+
+
+void ReplayPlayer::detach(Mixer_Replay *backend)
+{
+	m_backends.remove(backend->m_recordedId);
+}
+
+
+void ReplayPlayer::schedule()
+{
+	if (m_next>=m_records.count())
+	{
+		const qint64 recorded = m_records.isEmpty() ? 0 : m_records.last().usecs/1000;
+		qCDebug(KMIX_LOG) << "Replay finished," << m_records.count() << "records in"
+				  << m_clock.elapsed() << "ms, recorded in" << recorded << "ms";
+		return;
+	}
+
+	qint64 delay = 0;
+	if (m_speed>0)
+	{
+		const qint64 due = static_cast<qint64>(m_records.at(m_next).usecs/1000/m_speed);
+		delay = qMax(due-m_clock.elapsed(), Q_INT64_C(0));
+	}
+	m_timer.start(static_cast<int>(delay));
+}
+
+
+void ReplayPlayer::playNext()
+{
+	const int index = m_next++;
+	const ReplayRecord &record = m_records.at(index);
+	Mixer_Replay *backend = m_backends.value(record.mixerId);
+
+	switch (record.type)
+	{
+		case BackendRecorder::Topology:
+			// The first one was used to open the mixer
+			if (backend!=nullptr && index!=m_firstTopology.value(record.mixerId)) backend->setTopology(record.payload);
+			break;
+
+		case BackendRecorder::Values:
+			if (backend!=nullptr) backend->setValues(record.payload);
+			break;
+
+		case BackendRecorder::Event:
+		{
+			QDataStream stream(record.payload);
+			stream.setVersion(QDataStream::Qt_5_6);
+			QString description;
+			stream >> description;
+			KMixTrace::instant("replayed event", "backend", description);
+			break;
+		}
+
+		default:
+			break;					// from a later version
+	}
+
+	schedule();
+}
+
+
+bool BackendReplay::load(const QString &fileName, double speed)
+{
+	return (ReplayPlayer::load(fileName, speed));
+}
+
+
+bool BackendReplay::isLoaded()
+{
+	return (ReplayPlayer::instance()!=nullptr);
+}
+
+
+QString BackendReplay::driverName()
+{
+	return (QStringLiteral("Replay"));
+}
+
+
+Mixer_Backend *REPLAY_getMixer(Mixer *mixer, int device)
+{
+	return (new Mixer_Replay(mixer, device));
+}
+
+
+QString REPLAY_getDriverName()
+{
+	return (BackendReplay::driverName());
+}
+
+
+Mixer_Replay::Mixer_Replay(Mixer *mixer, int device)
+	: Mixer_Backend(mixer, device)
+{
+}
+
+
+Mixer_Replay::~Mixer_Replay()
+{
+	close();
+}
+
+
+QString Mixer_Replay::getDriverName()
+{
+	// As recorded, so that the mixer IDs are the same
+	return (m_driver.isEmpty() ? BackendReplay::driverName() : m_driver);
+}
+
+
+int Mixer_Replay::open()
+{
+	ReplayPlayer *player = ReplayPlayer::instance();
+	if (player==nullptr || m_devnum>=player->mixerIds().count()) return (Mixer::ERR_OPEN);
+
+	m_recordedId = player->mixerIds().at(m_devnum);
+	QDataStream stream(player->firstTopology(m_recordedId));
+	stream.setVersion(QDataStream::Qt_5_6);
+
+	QString baseName, udi, masterId;
+	qint32 cardInstance;
+	bool dynamic;
+	quint32 controlCount;
+	stream >> m_driver >> baseName >> cardInstance >> udi >> dynamic >> masterId >> controlCount;
+
+	// The middle part of the recorded "driver::name:instance" ID
+	m_backendId = m_recordedId.section(QLatin1String("::"), 1).section(':', 0, -2);
+	registerCard(baseName);
+	_cardInstance = cardInstance;
+	_udi = udi;
+	if (dynamic) _mixer->setDynamic();
+
+	for (quint32 c = 0; c<controlCount && stream.status()==QDataStream::Ok; ++c)
+	{
+		shared_ptr<MixDevice> md = TopologyCache::readControl(stream, _mixer);
+		m_mixDevices.append(md);
+		if (md->id()==masterId) m_recommendedMaster = md;
+	}
+	if (stream.status()!=QDataStream::Ok) return (Mixer::ERR_READ);
+
+	qCDebug(KMIX_LOG) << "Replaying" << m_recordedId << "with" << m_mixDevices.count() << "controls";
+	player->attach(this);
+	return (0);
+}
+
+
+int Mixer_Replay::close()
+{
+	ReplayPlayer *player = ReplayPlayer::instance();
+	if (player!=nullptr) player->detach(this);
+	m_pending.clear();
+	closeCommon();
+	return (0);
+}
+
+
+void Mixer_Replay::setValues(const QByteArray &payload)
+{
+	QDataStream stream(payload);
+	stream.setVersion(QDataStream::Qt_5_6);
+
+	quint32 count;
+	stream >> count;
+	for (quint32 i = 0; i<count && stream.status()==QDataStream::Ok; ++i)
+	{
+		QString id;
+		BackendRecorder::State state;
+		stream >> id >> state;
+		m_pending.insert(id, state);
+	}
+
+	// As a backend does when it sees a change
+	readSetFromHW();
+}
+
+
+void Mixer_Replay::setTopology(const QByteArray &payload)
+{
+	QDataStream stream(payload);
+	stream.setVersion(QDataStream::Qt_5_6);
+
+	QString driver, baseName, udi, masterId;
+	qint32 cardInstance;
+	bool dynamic;
+	quint32 controlCount;
+	stream >> driver >> baseName >> cardInstance >> udi >> dynamic >> masterId >> controlCount;
+
+	// Keep the controls that are still there, so that their GUI stays
+	MixSet controls;
+	for (quint32 c = 0; c<controlCount && stream.status()==QDataStream::Ok; ++c)
+	{
+		shared_ptr<MixDevice> md = TopologyCache::readControl(stream, _mixer);
+		shared_ptr<MixDevice> existing = m_mixDevices.get(md->id());
+		if (existing)
+		{
+			m_pending.insert(md->id(), BackendRecorder::stateOf(md));
+			controls.append(existing);
+		}
+		else controls.append(md);
+	}
+
+	bool listChanged = (controls.count()!=m_mixDevices.count());
+	for (int i = 0; !listChanged && i<controls.count(); ++i)
+	{
+		if (controls.at(i)!=m_mixDevices.at(i)) listChanged = true;
+	}
+
+	if (listChanged)
+	{
+		m_mixDevices = controls;
+		m_recommendedMaster = m_mixDevices.get(masterId);
+		ControlManager::instance().announce(_mixer->id(), ControlManager::ControlList, getDriverName());
+	}
+
+	if (!m_pending.isEmpty()) readSetFromHW();
+}
+
+
+int Mixer_Replay::readVolumeFromHW(const QString &id, shared_ptr<MixDevice> md)
+{
+	QHash<QString,BackendRecorder::State>::iterator it = m_pending.find(id);
+	if (it==m_pending.end()) return (Mixer::OK_UNCHANGED);
+
+	const bool changed = BackendRecorder::applyState(it.value(), md);
+	m_pending.erase(it);
+	return (changed ? Mixer::OK : Mixer::OK_UNCHANGED);
+}
+
+
+int Mixer_Replay::writeVolumeToHW(const QString &, shared_ptr<MixDevice>)
+{
+	// Accepted, but the recording decides what the hardware reports
+	return (Mixer::OK);
+}
+
+
+void Mixer_Replay::setEnumIdHW(const QString &, unsigned int)
+{
+}
+
+
+unsigned int Mixer_Replay::enumIdHW(const QString &id)
+{
+	shared_ptr<MixDevice> md = m_mixDevices.get(id);
+	return (md ? md->enumId() : 0);
+}
@@ -0,0 +1,91 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef MIXER_REPLAY_H
+#define MIXER_REPLAY_H
+
+#include <QHash>
+
+#include "backends/mixer_backend.h"
+#include "core/backendrecorder.h"
+#include "kmixcore_export.h"
+
+/**
+ * Loads a recording made by BackendRecorder, to be played back by the
+ * "Replay" backend.  The mixers of the recording are created with the
+ * same IDs and controls as the recorded ones, and the recorded values
+ * are fed through the usual Mixer_Backend::readSetFromHW() path at the
+ * recorded times.
+ */
+class KMIXCORE_EXPORT BackendReplay
+{
+	public:
+		/**
+		 * Load a recording to be played once the Replay backend is opened.
+		 *
+		 * @param speed how many times faster than it was recorded to
+		 * play back, or 0 to play back as fast as possible
+		 * @return @c true if the recording could be read
+		 */
+		static bool load(const QString &fileName, double speed);
+		static bool isLoaded();
+
+		/// The name of the Replay backend, to select it
+		static QString driverName();
+};
+
+
+/**
+ * A mixer of a recording that is being replayed.  It does not access any
+ * hardware, and is never open so that its volumes are not saved.
+ */
+class Mixer_Replay : public Mixer_Backend
+{
+	Q_OBJECT
+
+	friend class ReplayPlayer;
+
+	public:
+		Mixer_Replay(Mixer *mixer, int device);
+		virtual ~Mixer_Replay();
+
+	protected:
+		int open() override;
+		int close() override;
+
+		QString getDriverName() override;
+		QString getId() const override			{ return (m_backendId); }
+		bool needsPolling() override			{ return (false); }
+		bool hasChangedControls() override		{ return (!m_pending.isEmpty()); }
+
+		int readVolumeFromHW(const QString &id, shared_ptr<MixDevice> md) override;
+		int writeVolumeToHW(const QString &id, shared_ptr<MixDevice> md) override;
+		void setEnumIdHW(const QString &id, unsigned int) override;
+		unsigned int enumIdHW(const QString &id) override;
+
+	private:
+		void setTopology(const QByteArray &payload);
+		void setValues(const QByteArray &payload);
+
+		QString m_recordedId;
+		QString m_driver;
+		QString m_backendId;
+		QHash<QString,BackendRecorder::State> m_pending;	// read by the next readSetFromHW()
+};
+
+#endif /* MIXER_REPLAY_H */
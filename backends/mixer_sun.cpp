@@ -220,7 +220,7 @@ int Mixer_SUN::open()
 //======================================================================
 int Mixer_SUN::close()
 {
-   _pollingTimer->stop();
+   stopPolling();
    m_isOpen = false;
    int l_i_ret = ::close( fd );
    closeCommon();
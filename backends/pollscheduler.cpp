@@ -0,0 +1,193 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "backends/pollscheduler.h"
+
+#include <QStringList>
+
+#include "backends/mixer_backend.h"
+#include "core/ControlManager.h"
+#include "core/mixer.h"
+#include "kmix_debug.h"
+#include "settings.h"
+
+// The backends that have their own PollInterval settings, in the order
+// of the values of the Backend parameter in settings.kcfg.  Any other
+// backend uses the last ("Other") setting.
+static const QStringList s_settingsBackends = { "OSS", "OSS4", "SUNAudio", "Other" };
+
+static PollScheduler *instanceSingleton = nullptr;
+
+
+PollScheduler *PollScheduler::instance()
+{
+	if (instanceSingleton==nullptr) instanceSingleton = new PollScheduler();
+	return (instanceSingleton);
+}
+
+
+PollScheduler::PollScheduler()
+	: m_polling(false)
+{
+	m_timer.setSingleShot(true);
+	connect(&m_timer, &QTimer::timeout, this, &PollScheduler::wakeup);
+	m_clock.start();
+}
+
+
+void PollScheduler::add(Mixer_Backend *backend)
+{
+	int idx = s_settingsBackends.indexOf(backend->getDriverName());
+	if (idx<0) idx = s_settingsBackends.count()-1;
+
+	Entry entry;
+	entry.fastInterval = Settings::pollIntervalFast(idx);
+	entry.slowInterval = qMax(Settings::pollIntervalSlow(idx), entry.fastInterval);
+	entry.interval = entry.fastInterval;
+	entry.due = m_clock.elapsed()+entry.interval;
+	entry.idle = false;				// until the first poll
+	m_entries.insert(backend, entry);
+
+	qCDebug(KMIX_LOG) << "Polling" << backend->getDriverName() << backend->getId()
+			  << "every" << entry.fastInterval << "to" << entry.slowInterval << "ms";
+	reschedule();
+}
+
+
+void PollScheduler::remove(Mixer_Backend *backend)
+{
+	if (m_entries.remove(backend)>0) reschedule();
+}
+
+
+void PollScheduler::promote(Mixer_Backend *backend)
+{
+	QHash<Mixer_Backend *,Entry>::iterator it = m_entries.find(backend);
+	if (it==m_entries.end()) return;
+
+	Entry &entry = it.value();
+	if (entry.interval==entry.fastInterval && entry.due>=0) return;
+
+	const qint64 fastDue = m_clock.elapsed()+entry.fastInterval;
+	entry.interval = entry.fastInterval;
+	entry.due = (entry.due<0 ? fastDue : qMin(entry.due, fastDue));
+	if (!m_polling) reschedule();
+}
+
+
+void PollScheduler::polled(Mixer_Backend *backend, bool changed)
+{
+	QHash<Mixer_Backend *,Entry>::iterator it = m_entries.find(backend);
+	if (it==m_entries.end()) return;
+
+	Entry &entry = it.value();
+	entry.idle = !hasConsumers(backend);
+	if (entry.idle)
+	{
+		// Nobody is interested, only keep a heartbeat if there is one
+		const int idleInterval = Settings::pollIntervalIdle();
+		if (idleInterval>0)
+		{
+			entry.interval = qMax(idleInterval, entry.slowInterval);
+			entry.due = m_clock.elapsed()+entry.interval;
+		}
+		else entry.due = -1;
+	}
+	else
+	{
+		// Exponential back-off while nothing changes
+		if (changed) entry.interval = entry.fastInterval;
+		else entry.interval = qMin(entry.interval*2, entry.slowInterval);
+		entry.due = m_clock.elapsed()+entry.interval;
+	}
+	if (!m_polling) reschedule();
+}
+
+
+void PollScheduler::consumersChanged()
+{
+	bool resumed = false;
+	for (QHash<Mixer_Backend *,Entry>::iterator it = m_entries.begin(); it!=m_entries.end(); ++it)
+	{
+		Entry &entry = it.value();
+		if (!entry.idle || !hasConsumers(it.key())) continue;
+
+		qCDebug(KMIX_LOG) << "Resume polling" << it.key()->getId();
+		entry.idle = false;
+		entry.interval = entry.fastInterval;
+		entry.due = m_clock.elapsed();
+		resumed = true;
+	}
+	if (resumed && !m_polling) reschedule();
+}
+
+
+bool PollScheduler::hasConsumers(Mixer_Backend *backend)
+{
+	return (ControlManager::instance().hasActiveListeners(backend->_mixer->id(), ControlManager::Volume));
+}
+
+
+/**
+ * Poll all of the backends that are due now, and those that would be
+ * due soon after, so that they do not need a wakeup of their own.
+ */
+void PollScheduler::wakeup()
+{
+	const qint64 now = m_clock.elapsed();
+	QList<Mixer_Backend *> due;
+	for (QHash<Mixer_Backend *,Entry>::const_iterator it = m_entries.constBegin(); it!=m_entries.constEnd(); ++it)
+	{
+		const Entry &entry = it.value();
+		if (entry.due>=0 && entry.due<=now+entry.interval/4) due.append(it.key());
+	}
+
+	m_polling = true;
+	for (Mixer_Backend *backend : qAsConst(due))
+	{
+		// The backend may have been closed by polling another one
+		if (!m_entries.contains(backend)) continue;
+
+		m_entries[backend].due = now+m_entries[backend].interval;
+		backend->readSetFromHW();		// reports back to polled()
+	}
+	m_polling = false;
+
+	reschedule();
+}
+
+
+void PollScheduler::reschedule()
+{
+	qint64 next = -1;
+	for (const Entry &entry : qAsConst(m_entries))
+	{
+		if (entry.due<0) continue;		// suspended
+		if (next<0 || entry.due<next) next = entry.due;
+	}
+
+	if (next<0)
+	{
+		m_timer.stop();
+		return;
+	}
+
+	const int delay = static_cast<int>(qMax(next-m_clock.elapsed(), Q_INT64_C(0)));
+	m_timer.setTimerType(delay>=1000 ? Qt::VeryCoarseTimer : Qt::CoarseTimer);
+	m_timer.start(delay);
+}
@@ -0,0 +1,100 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef POLLSCHEDULER_H
+#define POLLSCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTimer>
+
+class Mixer_Backend;
+
+/**
+ * Polls all of the backends that cannot see changes by themselves
+ * (those for which needsPolling() is true) with a single timer.
+ *
+ * Each backend is polled at its fast interval after a change or after
+ * the user has changed a control, and the interval is doubled after
+ * every poll that finds no change, up to its slow interval.  Backends
+ * that are due at about the same time are polled together, and long
+ * intervals use a very coarse timer, so that the system can group the
+ * wakeups with those of other applications.
+ *
+ * A backend for which there is no active consumer of volume changes
+ * (see ControlManager::hasActiveListeners()) is only polled at the
+ * PollIntervalIdle heartbeat, or not at all if that is 0, until a
+ * consumer appears.
+ *
+ * The fast and slow intervals can be set for each backend with the
+ * PollIntervalFast and PollIntervalSlow settings.
+ */
+class PollScheduler : public QObject
+{
+	Q_OBJECT
+
+	public:
+		static PollScheduler *instance();
+
+		void add(Mixer_Backend *backend);
+		void remove(Mixer_Backend *backend);
+
+		/**
+		 * Poll the backend at its fast interval from now on,
+		 * e.g. because the user is changing its controls.
+		 */
+		void promote(Mixer_Backend *backend);
+
+		/**
+		 * Report the result of polling a backend, so that
+		 * the next interval can be decided.
+		 */
+		void polled(Mixer_Backend *backend, bool changed);
+
+		/**
+		 * There may be new consumers of volume changes, so poll
+		 * the idle backends which now have one straight away.
+		 */
+		void consumersChanged();
+
+	private slots:
+		void wakeup();
+
+	private:
+		PollScheduler();
+
+		struct Entry
+		{
+			int interval;
+			int fastInterval;
+			int slowInterval;
+			qint64 due;			// -1 if suspended
+			bool idle;
+		};
+
+		static bool hasConsumers(Mixer_Backend *backend);
+		void reschedule();
+
+		QHash<Mixer_Backend *,Entry> m_entries;
+		QTimer m_timer;
+		QElapsedTimer m_clock;
+		bool m_polling;
+};
+
+#endif /* POLLSCHEDULER_H */
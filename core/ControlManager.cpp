@@ -21,6 +21,9 @@
 
 #include "settings.h"
 #include "kmix_debug.h"
+#include "backends/pollscheduler.h"
+#include "core/kmixstats.h"
+#include "core/kmixtrace.h"
 
 
 struct Listener
@@ -55,6 +58,8 @@ void ControlManager::announce(const QString &mixerId, ControlManager::ChangeType
 {
 	bool listenersModified = true;			// do loop at least once
 	QSet<const Listener *> processedListeners;	// listeners that have been processed
+	int dispatches = 0;
+	KMixTrace::Span span("announce", "control", mixerId);
 
 	if (Settings::debugControlManager())
 	{
@@ -90,6 +95,7 @@ void ControlManager::announce(const QString &mixerId, ControlManager::ChangeType
 						  << "change type" << changeType;
 			}
 
+			KMixTrace::Span listenerSpan("controlsChange", "control", listener->sourceId);
 			bool success = QMetaObject::invokeMethod(listener->target,
 								 "controlsChange",
 								 Qt::DirectConnection,
@@ -99,6 +105,7 @@ void ControlManager::announce(const QString &mixerId, ControlManager::ChangeType
 				qCWarning(KMIX_LOG) << "failed to signal"
 						    << listener->target->metaObject()->className();
 			}
+			else ++dispatches;
 
 			processedListeners.insert(listener);
 			if (m_listenersChanged)
@@ -115,6 +122,8 @@ void ControlManager::announce(const QString &mixerId, ControlManager::ChangeType
 			}
 		}					// inner loop
 	}						// outer loop
+
+	KMixStats::announce(changeType, dispatches);
 }
 
 
@@ -153,6 +162,8 @@ void ControlManager::addListener(const QString &mixerId, ControlManager::ChangeT
 	{
 		qCDebug(KMIX_LOG) << "now have" << m_listeners.size() << "listeners";
 	}
+
+	if ((changeTypes & ControlManager::Volume) && !m_inactiveTargets.contains(target)) consumersAdded();
 }
 
 
@@ -185,6 +196,50 @@ void ControlManager::removeListener(QObject *target, ControlManager::ChangeType
 		// See comment in addListener() above.
 		m_listenersChanged = true;
 	}
+
+	if (changeType==ControlManager::None) m_inactiveTargets.remove(target);
+}
+
+
+void ControlManager::setListenerActive(QObject *target, bool active)
+{
+	if (active)
+	{
+		if (m_inactiveTargets.remove(target))
+		{
+			if (Settings::debugControlManager()) qCDebug(KMIX_LOG) << "Listener target" << target << "is active";
+			consumersAdded();
+		}
+	}
+	else if (!m_inactiveTargets.contains(target))
+	{
+		if (Settings::debugControlManager()) qCDebug(KMIX_LOG) << "Listener target" << target << "is inactive";
+		m_inactiveTargets.insert(target);
+	}
+}
+
+
+bool ControlManager::hasActiveListeners(const QString &mixerId, ControlManager::ChangeType changeType) const
+{
+	for (const Listener *listener : qAsConst(m_listeners))
+	{
+		if (listener->changeType!=changeType) continue;
+		if (!listener->mixerId.isEmpty() && listener->mixerId!=mixerId) continue;
+		if (m_inactiveTargets.contains(listener->target)) continue;
+		return (true);
+	}
+	return (false);
+}
+
+
+/**
+ * There may be a new consumer of volume changes, so resume polling of
+ * any backend that was idle for the lack of one.  Polling is reduced
+ * again by the PollScheduler itself when there are no consumers left.
+ */
+void ControlManager::consumersAdded()
+{
+	PollScheduler::instance()->consumersChanged();
 }
 
 
@@ -22,6 +22,7 @@
 
 #include <qflags.h>
 #include <qlist.h>
+#include <qset.h>
 
 #include "kmixcore_export.h"
 
@@ -91,6 +92,27 @@ public:
    */
   void removeListener(QObject *target, ControlManager::ChangeType changeType, const QString &sourceId = QString());
 
+  /**
+   * Mark the listeners of a target as active or not.
+   *
+   * An inactive listener (e.g. a view that is not shown) is still notified of
+   * changes, but is not a consumer for @c hasActiveListeners().  Listeners are
+   * active unless they are marked otherwise.
+   *
+   * @param target The object that was, or will be, registered to be notified
+   * @param active Whether its listeners are active
+   */
+  void setListenerActive(QObject *target, bool active);
+
+  /**
+   * Check whether there is an active listener for a mixer and change type.
+   *
+   * @param mixerId The mixer ID
+   * @param changeType The change type
+   * @return @c true if an active listener is registered for the mixer or for all mixers
+   */
+  bool hasActiveListeners(const QString &mixerId, ControlManager::ChangeType changeType) const;
+
   /**
    * Warn that an an unexpected change type announcement has been received.
    *
@@ -108,8 +130,10 @@ public:
   
 private:
     ControlManager();
+    void consumersAdded();
 
     QList<Listener *> m_listeners;
+    QSet<QObject *> m_inactiveTargets;
     bool m_listenersChanged;
 };
 
@@ -0,0 +1,267 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "core/backendrecorder.h"
+
+#include <atomic>
+
+#include <QDataStream>
+#include <QFile>
+#include <QMutex>
+
+#include "core/mixer.h"
+#include "core/topologycache.h"
+#include "core/volume.h"
+#include "kmix_debug.h"
+
+static BackendRecorder *instanceSingleton = nullptr;
+static std::atomic<bool> s_recording(false);
+
+// Backends may read in threads other than the main one
+static QMutex s_mutex;
+
+
+static QList<QPair<qint32,qint64> > channelsOf(Volume &vol)
+{
+	QList<QPair<qint32,qint64> > channels;
+	for (const VolumeChannel &vc : vol.getVolumes())
+	{
+		channels.append(qMakePair(static_cast<qint32>(vc.chid), static_cast<qint64>(vc.volume)));
+	}
+	return (channels);
+}
+
+static bool applyChannels(const QList<QPair<qint32,qint64> > &channels, Volume &vol)
+{
+	bool changed = false;
+	for (const QPair<qint32,qint64> &channel : channels)
+	{
+		const Volume::ChannelID chid = static_cast<Volume::ChannelID>(channel.first);
+		if (!vol.getVolumes().contains(chid) || vol.getVolume(chid)==channel.second) continue;
+		vol.setVolume(chid, channel.second);
+		changed = true;
+	}
+	return (changed);
+}
+
+
+QDataStream &operator<<(QDataStream &stream, const BackendRecorder::State &state)
+{
+	return (stream << state.enumId << state.muted << state.recSource << state.playback << state.capture);
+}
+
+QDataStream &operator>>(QDataStream &stream, BackendRecorder::State &state)
+{
+	return (stream >> state.enumId >> state.muted >> state.recSource >> state.playback >> state.capture);
+}
+
+
+BackendRecorder::State BackendRecorder::stateOf(const shared_ptr<MixDevice> &md)
+{
+	State state;
+	state.enumId = md->enumId();
+	state.muted = md->isMuted();
+	state.recSource = md->isRecSource();
+	state.playback = channelsOf(md->playbackVolume());
+	state.capture = channelsOf(md->captureVolume());
+	return (state);
+}
+
+
+bool BackendRecorder::applyState(const BackendRecorder::State &state, shared_ptr<MixDevice> md)
+{
+	bool changed = applyChannels(state.playback, md->playbackVolume());
+	if (applyChannels(state.capture, md->captureVolume())) changed = true;
+
+	if (md->hasMuteSwitch() && md->isMuted()!=state.muted)
+	{
+		md->setMuted(state.muted);
+		changed = true;
+	}
+	if (md->captureVolume().hasSwitch() && md->isRecSource()!=state.recSource)
+	{
+		md->setRecSource(state.recSource);
+		changed = true;
+	}
+	if (md->isEnum() && static_cast<qint32>(md->enumId())!=state.enumId)
+	{
+		md->setEnumId(state.enumId);
+		changed = true;
+	}
+	return (changed);
+}
+
+
+bool BackendRecorder::start(const QString &fileName)
+{
+	stop();
+
+	QFile *file = new QFile(fileName);
+	if (!file->open(QIODevice::WriteOnly|QIODevice::Truncate))
+	{
+		qCWarning(KMIX_LOG) << "Cannot record to" << fileName << file->errorString();
+		delete file;
+		return (false);
+	}
+
+	QMutexLocker locker(&s_mutex);
+	instanceSingleton = new BackendRecorder(file);
+	s_recording = true;
+	qCDebug(KMIX_LOG) << "Recording backends to" << fileName;
+	return (true);
+}
+
+
+void BackendRecorder::stop()
+{
+	QMutexLocker locker(&s_mutex);
+	if (instanceSingleton==nullptr) return;
+
+	s_recording = false;
+	delete instanceSingleton;
+	instanceSingleton = nullptr;
+}
+
+
+bool BackendRecorder::isRecording()
+{
+	return (s_recording.load(std::memory_order_relaxed));
+}
+
+
+BackendRecorder::BackendRecorder(QFile *file)
+	: m_file(file),
+	  m_stream(new QDataStream(file))
+{
+	m_stream->setVersion(QDataStream::Qt_5_6);
+	*m_stream << fileMagic << fileVersion;
+	m_clock.start();
+
+	ControlManager::instance().addListener(
+		QString(),				// all mixers
+		ControlManager::ControlList,
+		this,
+		QString("BackendRecorder"));
+}
+
+
+BackendRecorder::~BackendRecorder()
+{
+	ControlManager::instance().removeListener(this);
+	delete m_stream;
+	m_file->close();
+	qCDebug(KMIX_LOG) << "Recorded" << m_file->size() << "bytes to" << m_file->fileName();
+	delete m_file;
+}
+
+
+void BackendRecorder::writeRecord(BackendRecorder::RecordType type, const QString &mixerId, const QByteArray &payload)
+{
+	*m_stream << static_cast<quint8>(type) << static_cast<qint64>(m_clock.nsecsElapsed()/1000)
+		  << mixerId << payload;
+}
+
+
+bool BackendRecorder::topologyChanged(Mixer *mixer) const
+{
+	QHash<QString,QStringList>::const_iterator it = m_recordedControls.constFind(mixer->id());
+	if (it==m_recordedControls.constEnd()) return (true);
+
+	const MixSet &mixSet = mixer->getMixSet();
+	if (mixSet.count()!=it.value().count()) return (true);
+	for (int i = 0; i<mixSet.count(); ++i)
+	{
+		if (mixSet.at(i)->id()!=it.value().at(i)) return (true);
+	}
+	return (false);
+}
+
+
+void BackendRecorder::recordTopology(Mixer *mixer)
+{
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_6);
+
+	QStringList controlIds;
+	for (const shared_ptr<MixDevice> &md : qAsConst(mixer->getMixSet())) controlIds.append(md->id());
+
+	const shared_ptr<MixDevice> master = mixer->getLocalMasterMD();
+	stream << mixer->getDriverName() << mixer->getBaseName() << static_cast<qint32>(mixer->getCardInstance())
+	       << mixer->udi() << mixer->isDynamic() << (master ? master->id() : QString())
+	       << static_cast<quint32>(controlIds.count());
+	for (const shared_ptr<MixDevice> &md : qAsConst(mixer->getMixSet())) TopologyCache::writeControl(stream, md);
+
+	writeRecord(Topology, mixer->id(), payload);
+	m_recordedControls.insert(mixer->id(), controlIds);
+}
+
+
+void BackendRecorder::recordValues(Mixer *mixer, const QList<shared_ptr<MixDevice> > &mds)
+{
+	if (!isRecording() || mds.isEmpty()) return;
+
+	QMutexLocker locker(&s_mutex);
+	if (instanceSingleton==nullptr) return;
+
+	// The values of a control that is not in the last recorded
+	// topology could not be replayed
+	const QStringList recorded = instanceSingleton->m_recordedControls.value(mixer->id());
+	for (const shared_ptr<MixDevice> &md : mds)
+	{
+		if (recorded.contains(md->id())) continue;
+		instanceSingleton->recordTopology(mixer);
+		break;
+	}
+
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_6);
+	stream << static_cast<quint32>(mds.count());
+	for (const shared_ptr<MixDevice> &md : mds) stream << md->id() << stateOf(md);
+
+	instanceSingleton->writeRecord(Values, mixer->id(), payload);
+}
+
+
+void BackendRecorder::recordEvent(const QString &mixerId, const QString &description)
+{
+	if (!isRecording()) return;
+
+	QMutexLocker locker(&s_mutex);
+	if (instanceSingleton==nullptr) return;
+
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_6);
+	stream << description;
+
+	instanceSingleton->writeRecord(Event, mixerId, payload);
+}
+
+
+void BackendRecorder::controlsChange(ControlManager::ChangeType changeType)
+{
+	if (changeType!=ControlManager::ControlList) return;
+
+	QMutexLocker locker(&s_mutex);
+	for (Mixer *mixer : qAsConst(Mixer::mixers()))
+	{
+		if (topologyChanged(mixer)) recordTopology(mixer);
+	}
+}
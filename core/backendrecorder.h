@@ -0,0 +1,129 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef BACKENDRECORDER_H
+#define BACKENDRECORDER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+
+#include "core/ControlManager.h"
+#include "core/mixdevice.h"
+#include "kmixcore_export.h"
+
+class Mixer;
+class QDataStream;
+class QFile;
+
+/**
+ * Records what the backends read from the hardware, so that it can be
+ * replayed later by the "Replay" backend (see BackendReplay) without the
+ * hardware or sound server that it came from.
+ *
+ * A recording is a sequence of records, each with the time since the
+ * recording was started and the mixer that it is for:
+ *
+ * @li Topology: the identity of a mixer and all of its controls with
+ *     their values, written when a mixer is first seen and whenever its
+ *     list of controls changes
+ * @li Values: the new values of the controls that a backend has found
+ *     to have changed
+ * @li Event: a backend event that did not itself change a value, such
+ *     as a PulseAudio subscription event
+ */
+class KMIXCORE_EXPORT BackendRecorder : public QObject
+{
+	Q_OBJECT
+
+	public:
+		enum RecordType
+		{
+			Topology = 1,
+			Values = 2,
+			Event = 3
+		};
+
+		/// The values of a control, as read from the hardware
+		struct State
+		{
+			qint32 enumId;
+			bool muted;
+			bool recSource;
+			QList<QPair<qint32,qint64> > playback;		// channel ID and volume
+			QList<QPair<qint32,qint64> > capture;
+		};
+
+		static const quint32 fileMagic = 0x4b4d5852;	// "KMXR"
+		static const quint32 fileVersion = 1;
+
+		/**
+		 * Start recording to @p fileName, replacing it if it exists.
+		 *
+		 * @return @c true if the file could be created
+		 */
+		static bool start(const QString &fileName);
+		static void stop();
+		static bool isRecording();
+
+		/**
+		 * Record that the backend of @p mixer has read new values
+		 * for the controls @p mds.
+		 */
+		static void recordValues(Mixer *mixer, const QList<shared_ptr<MixDevice> > &mds);
+
+		/**
+		 * Record a backend event, for information.  The @p mixerId
+		 * may be empty if the event is not for a particular mixer.
+		 */
+		static void recordEvent(const QString &mixerId, const QString &description);
+
+		static BackendRecorder::State stateOf(const shared_ptr<MixDevice> &md);
+
+		/**
+		 * Set the values of a control from a recorded state.
+		 *
+		 * @return @c true if any of the values changed
+		 */
+		static bool applyState(const BackendRecorder::State &state, shared_ptr<MixDevice> md);
+
+	public slots:
+		void controlsChange(ControlManager::ChangeType changeType);
+
+	private:
+		BackendRecorder(QFile *file);
+		virtual ~BackendRecorder();
+
+		void writeRecord(BackendRecorder::RecordType type, const QString &mixerId, const QByteArray &payload);
+		void recordTopology(Mixer *mixer);
+		bool topologyChanged(Mixer *mixer) const;
+
+		QFile *m_file;
+		QDataStream *m_stream;
+		QElapsedTimer m_clock;
+		QHash<QString,QStringList> m_recordedControls;	// mixer ID to control IDs
+};
+
+KMIXCORE_EXPORT QDataStream &operator<<(QDataStream &stream, const BackendRecorder::State &state);
+KMIXCORE_EXPORT QDataStream &operator>>(QDataStream &stream, BackendRecorder::State &state);
+
+#endif /* BACKENDRECORDER_H */
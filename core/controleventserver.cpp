@@ -0,0 +1,392 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "core/controleventserver.h"
+
+#include <QDateTime>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStandardPaths>
+
+#include "core/mixer.h"
+#include "core/volume.h"
+#include "dbus/dbusmixerobject.h"
+#include "kmix_debug.h"
+#include "settings.h"
+
+// The most that is queued for a client before it is considered to be
+// not keeping up.  Beyond this no more state records are queued and
+// no more commands are read from it.
+static const qint64 maxPendingBytes = 64*1024;
+
+static ControlEventServer *instanceSingleton = nullptr;
+
+
+void ControlEventServer::initialize(QObject *parent, const QString &name)
+{
+	Q_ASSERT(instanceSingleton==nullptr);
+	if (!Settings::eventSocket()) return;
+
+	instanceSingleton = new ControlEventServer(parent, name);
+	if (!instanceSingleton->listen())
+	{
+		delete instanceSingleton;
+		instanceSingleton = nullptr;
+	}
+}
+
+
+ControlEventServer *ControlEventServer::instance()
+{
+	return (instanceSingleton);
+}
+
+
+ControlEventServer::ControlEventServer(QObject *parent, const QString &name)
+	: QObject(parent),
+	  m_name(name),
+	  m_server(new QLocalServer(this)),
+	  m_listening(false)
+{
+	connect(m_server, &QLocalServer::newConnection, this, &ControlEventServer::newConnection);
+}
+
+
+ControlEventServer::~ControlEventServer()
+{
+	ControlManager::instance().removeListener(this);
+	qDeleteAll(m_clients);
+	if (instanceSingleton==this) instanceSingleton = nullptr;
+}
+
+
+bool ControlEventServer::listen()
+{
+	const QString path = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation)+'/'+m_name;
+	QLocalServer::removeServer(path);
+	m_server->setSocketOptions(QLocalServer::UserAccessOption);
+	if (!m_server->listen(path))
+	{
+		qCWarning(KMIX_LOG) << "Cannot listen on" << path << m_server->errorString();
+		return (false);
+	}
+
+	qCDebug(KMIX_LOG) << "Event socket listening on" << path;
+	return (true);
+}
+
+
+void ControlEventServer::newConnection()
+{
+	while (QLocalSocket *socket = m_server->nextPendingConnection())
+	{
+		Client *client = new Client;
+		client->socket = socket;
+		client->resync = false;
+		m_clients.append(client);
+
+		// So that unread commands stay in the socket and block the client
+		socket->setReadBufferSize(maxPendingBytes);
+
+		connect(socket, &QLocalSocket::readyRead, this, [this, client]() { readCommands(client); });
+		connect(socket, &QLocalSocket::bytesWritten, this, [this, client]() { clientDrained(client); });
+		connect(socket, &QLocalSocket::disconnected, this, [this, client]() { removeClient(client); });
+
+		if (!m_listening)
+		{
+			// Only follow changes while somebody is interested
+			ControlManager::instance().addListener(QString(),
+							       ControlManager::ControlList|ControlManager::Volume,
+							       this, QString("ControlEventServer"));
+			m_listening = true;
+			updateRecords(true);
+		}
+		sendAll(client);
+	}
+}
+
+
+void ControlEventServer::removeClient(Client *client)
+{
+	m_clients.removeAll(client);
+	client->socket->disconnect(this);
+	client->socket->deleteLater();
+	delete client;
+
+	if (m_clients.isEmpty() && m_listening)
+	{
+		ControlManager::instance().removeListener(this);
+		m_listening = false;
+		m_records.clear();
+	}
+}
+
+
+void ControlEventServer::controlsChange(ControlManager::ChangeType changeType)
+{
+	switch (changeType)
+	{
+case ControlManager::ControlList:
+case ControlManager::Volume:
+		updateRecords(false);
+		break;
+
+default:
+		ControlManager::warnUnexpectedChangeType(changeType, this);
+		break;
+	}
+}
+
+
+static QByteArray channelValues(const Volume &vol)
+{
+	QByteArray result;
+	for (const VolumeChannel &ch : vol.getVolumes())
+	{
+		if (!result.isEmpty()) result += ',';
+		result += QByteArray::number(static_cast<qlonglong>(ch.volume));
+	}
+	return (result);
+}
+
+
+/**
+ * Find the controls that have changed since the records were last sent,
+ * and send them to all clients.
+ *
+ * @param force if @c true, just rebuild the records without sending
+ */
+void ControlEventServer::updateRecords(bool force)
+{
+	const QByteArray timestamp = QByteArray::number(QDateTime::currentMSecsSinceEpoch());
+	QHash<QByteArray,QByteArray> newRecords;
+	QByteArray changedList;
+	QByteArray changedControls;
+
+	for (Mixer *mixer : qAsConst(Mixer::mixers()))
+	{
+		const QByteArray mixerId = mixer->id().toUtf8();
+		bool listChanged = false;
+
+		for (const shared_ptr<MixDevice> md : qAsConst(mixer->getMixSet()))
+		{
+			const QByteArray key = mixerId+'\t'+md->id().toUtf8();
+			const QByteArray record = key+'\t'+
+						  (md->isMuted() ? '1' : '0')+'\t'+
+						  (md->isRecSource() ? '1' : '0')+'\t'+
+						  channelValues(md->playbackVolume())+'\t'+
+						  channelValues(md->captureVolume());
+			newRecords.insert(key, record);
+
+			QHash<QByteArray,QByteArray>::const_iterator it = m_records.constFind(key);
+			if (it==m_records.constEnd()) listChanged = true;
+			if (it==m_records.constEnd() || it.value()!=record)
+			{
+				changedControls += "V\t"+timestamp+'\t'+record+'\n';
+			}
+		}
+
+		if (!listChanged)
+		{
+			// See whether any control of this mixer has gone
+			const QByteArray prefix = mixerId+'\t';
+			for (QHash<QByteArray,QByteArray>::const_iterator it = m_records.constBegin(); it!=m_records.constEnd(); ++it)
+			{
+				if (it.key().startsWith(prefix) && !newRecords.contains(it.key()))
+				{
+					listChanged = true;
+					break;
+				}
+			}
+		}
+
+		if (listChanged) changedList += "L\t"+timestamp+'\t'+mixerId+'\n';
+	}
+
+	m_records = newRecords;
+	if (force) return;
+
+	const QByteArray data = changedList+changedControls;
+	if (data.isEmpty()) return;
+	for (Client *client : qAsConst(m_clients))
+	{
+		if (!client->resync) send(client, data);
+	}
+}
+
+
+void ControlEventServer::sendAll(Client *client)
+{
+	const QByteArray timestamp = QByteArray::number(QDateTime::currentMSecsSinceEpoch());
+	QByteArray data;
+	for (const QByteArray &record : qAsConst(m_records))
+	{
+		data += "V\t"+timestamp+'\t'+record+'\n';
+	}
+
+	client->resync = false;
+	send(client, data);
+}
+
+
+void ControlEventServer::send(Client *client, const QByteArray &data)
+{
+	if (client->socket->bytesToWrite()>maxPendingBytes)
+	{
+		// The client is not keeping up, so stop queueing
+		// changes and send everything when it has caught up.
+		client->resync = true;
+		return;
+	}
+
+	client->socket->write(data);
+}
+
+
+void ControlEventServer::clientDrained(Client *client)
+{
+	if (client->socket->bytesToWrite()>0) return;
+
+	if (client->resync) sendAll(client);
+	// Continue reading any commands held back
+	if (client->socket->bytesAvailable()>0) readCommands(client);
+}
+
+
+static bool isSwitchField(const QByteArray &field)
+{
+	return (field=="0" || field=="1" || field=="-");
+}
+
+
+/**
+ * Read and apply all of the complete commands available from a client,
+ * as one batch.
+ */
+void ControlEventServer::readCommands(Client *client)
+{
+	QLocalSocket *socket = client->socket;
+	// Apply back pressure, leaving the commands
+	// unread until the client reads its replies.
+	if (socket->bytesToWrite()>maxPendingBytes) return;
+
+	struct Command
+	{
+		shared_ptr<MixDevice> md;
+		QByteArray error;
+	};
+
+	QList<Command> commands;
+	QHash<Mixer *,QList<shared_ptr<MixDevice> > > changed;
+
+	while (socket->canReadLine())
+	{
+		const QList<QByteArray> fields = socket->readLine().trimmed().split('\t');
+		if (fields.isEmpty() || fields.first().isEmpty()) continue;
+
+		Command command;
+		if (fields.at(0)!="S" || fields.count()!=6)
+		{
+			command.error = "Invalid command";
+			commands.append(command);
+			continue;
+		}
+
+		Mixer *mixer = Mixer::findMixer(QString::fromUtf8(fields.at(1)));
+		shared_ptr<MixDevice> md = (mixer!=nullptr) ? mixer->getMixdeviceById(QString::fromUtf8(fields.at(2))) : shared_ptr<MixDevice>();
+		if (!md)
+		{
+			command.error = "No such control";
+			commands.append(command);
+			continue;
+		}
+
+		// Check all of the fields before changing anything
+		bool ok = true;
+		int volume = -1;
+		if (fields.at(3)!="-")
+		{
+			volume = fields.at(3).toInt(&ok);
+			if (ok && (volume<0 || volume>100)) ok = false;
+		}
+		if (!ok)
+		{
+			command.error = "Invalid volume";
+			commands.append(command);
+			continue;
+		}
+
+		if (!isSwitchField(fields.at(4)) || !isSwitchField(fields.at(5)))
+		{
+			command.error = "Invalid switch";
+			commands.append(command);
+			continue;
+		}
+
+		if (volume>=0) DBusMixerObject::applyControlProperty(md, "volume", volume);
+		if (fields.at(4)!="-") DBusMixerObject::applyControlProperty(md, "mute", fields.at(4)=="1");
+		if (fields.at(5)!="-") DBusMixerObject::applyControlProperty(md, "recordSource", fields.at(5)=="1");
+
+		command.md = md;
+		commands.append(command);
+		QList<shared_ptr<MixDevice> > &mds = changed[mixer];
+		if (!mds.contains(md)) mds.append(md);
+	}
+
+	// A line that does not fit into the read buffer can never be
+	// completed, so the client would wait for a reply forever.
+	const bool overlong = (!socket->canReadLine() && socket->bytesAvailable()>=maxPendingBytes);
+	if (overlong)
+	{
+		Command command;
+		command.error = "Line too long";
+		commands.append(command);
+	}
+
+	if (commands.isEmpty()) return;
+
+	// One write and announcement for each mixer
+	QHash<MixDevice *,int> results;
+	for (QHash<Mixer *,QList<shared_ptr<MixDevice> > >::const_iterator it = changed.constBegin(); it!=changed.constEnd(); ++it)
+	{
+		const QList<int> written = it.key()->commitVolumeChanges(it.value());
+		for (int i = 0; i<it.value().count(); ++i) results.insert(it.value().at(i).get(), written.value(i));
+	}
+
+	QByteArray replies;
+	for (const Command &command : qAsConst(commands))
+	{
+		if (!command.error.isEmpty())
+		{
+			replies += "R\t-1\t"+command.error+'\n';
+			continue;
+		}
+
+		const int err = results.value(command.md.get(), Mixer::OK);
+		if (err==Mixer::OK || err==Mixer::OK_UNCHANGED) replies += "R\t0\t\n";
+		else replies += "R\t"+QByteArray::number(err)+"\tWrite failed\n";
+	}
+
+	// The replies are always sent, even if state records are being held back
+	socket->write(replies);
+	if (overlong)
+	{
+		qCWarning(KMIX_LOG) << "Event socket command too long, disconnecting client";
+		socket->disconnectFromServer();
+	}
+}
@@ -0,0 +1,115 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef CONTROLEVENTSERVER_H
+#define CONTROLEVENTSERVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+
+#include "core/ControlManager.h"
+#include "kmixcore_export.h"
+
+class QLocalServer;
+class QLocalSocket;
+
+/**
+ * A local socket for clients that follow or set controls at a high
+ * rate, for which D-Bus has too much overhead.  It is only created
+ * if the EventSocket setting is on.
+ *
+ * The socket is "<name>" in the user's runtime directory.  All records
+ * are lines of tab separated fields.  The server sends:
+ *
+ *   V <msec> <mixer id> <control id> <muted> <recsrc> <playback> <capture>
+ *	The state of a control, sent for each control that has changed
+ *	when a Volume change is announced, and for all controls on
+ *	connection and after a control list change.  <msec> is the time
+ *	since the epoch, <muted> and <recsrc> are 0 or 1, and <playback>
+ *	and <capture> are the absolute volume of each channel separated
+ *	by commas (empty if there are none).
+ *
+ *   L <msec> <mixer id>
+ *	The controls of the mixer have changed.
+ *
+ *   R <status> <text>
+ *	The result of each set command, in order.  <status> is 0
+ *	for success, -1 for an invalid command or a Mixer::MixerError.
+ *
+ * The client may send:
+ *
+ *   S <mixer id> <control id> <volume> <muted> <recsrc>
+ *	Set a control.  <volume> is a percentage, <muted> and <recsrc>
+ *	are 0 or 1, and any of them may be "-" to leave it unchanged.
+ *	Nothing is changed if any of the fields is invalid.
+ *
+ * All of the complete commands received together are applied as one
+ * batch, with one hardware write and one announcement for each mixer.
+ *
+ * If a client does not read what is sent to it quickly enough, no
+ * more state records are queued for it, and all controls are sent once
+ * it has caught up.  Commands from that client are not read until then,
+ * so a client that sends faster than KMix can apply them is blocked.
+ * A client that sends a line longer than 64KiB is sent an error result
+ * and disconnected.
+ */
+class KMIXCORE_EXPORT ControlEventServer : public QObject
+{
+	Q_OBJECT
+
+	public:
+		static void initialize(QObject *parent, const QString &name);
+		static ControlEventServer *instance();
+
+	public slots:
+		void controlsChange(ControlManager::ChangeType changeType);
+
+	private slots:
+		void newConnection();
+
+	private:
+		struct Client
+		{
+			QLocalSocket *socket;
+			bool resync;			// send all controls when drained
+		};
+
+		ControlEventServer(QObject *parent, const QString &name);
+		~ControlEventServer();
+
+		bool listen();
+		void updateRecords(bool force);
+		void sendAll(Client *client);
+		void send(Client *client, const QByteArray &data);
+		void clientDrained(Client *client);
+		void readCommands(Client *client);
+		void removeClient(Client *client);
+
+		QString m_name;
+		QLocalServer *m_server;
+		QList<Client *> m_clients;
+		bool m_listening;
+
+		// The last state record sent for each control, keyed
+		// by the mixer and control ID, without the timestamp.
+		QHash<QByteArray,QByteArray> m_records;
+};
+
+#endif /* CONTROLEVENTSERVER_H */
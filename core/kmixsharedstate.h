@@ -0,0 +1,211 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef KMIXSHAREDSTATE_H
+#define KMIXSHAREDSTATE_H
+
+/*
+ * The layout of the shared memory segment in which KMix publishes the
+ * state of the controls of a mixer, and a reader for it.
+ *
+ * This header is installed for use by local clients.  It has no
+ * dependencies other than the C++11 standard library and POSIX, so that
+ * it can be used without Qt or linking to KMix.
+ *
+ * The segment is created by shm_open() with the name returned by
+ * kmixSharedStateName(), for the same user that is running KMix.  The
+ * KMix application and the KDE daemon module each have their own.
+ * The table is protected by a sequence lock: the writer makes the
+ * sequence number odd while updating and even again afterwards, so a
+ * reader retries if the number was odd or changed while it was copying.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define KMIX_SHARED_STATE_MAGIC		0x584d694bu	// "KMiX"
+#define KMIX_SHARED_STATE_VERSION	2
+#define KMIX_SHARED_STATE_CONTROLS	256		// maximum number of controls
+#define KMIX_SHARED_STATE_ID_LENGTH	128		// including the terminating null
+
+enum KMixSharedControlFlags
+{
+	KMixSharedMuted = 0x01,
+	KMixSharedRecordSource = 0x02,
+	KMixSharedCanMute = 0x04,
+	KMixSharedHasCaptureSwitch = 0x08
+};
+
+enum KMixSharedHeaderFlags
+{
+	KMixSharedTruncated = 0x01			// more than KMIX_SHARED_STATE_CONTROLS controls
+};
+
+/**
+ * The state of one control.  The volumes are the average over all
+ * channels, of playback if the control has it and capture otherwise.
+ */
+struct KMixSharedControl
+{
+	char id[KMIX_SHARED_STATE_ID_LENGTH];		// as for org.kde.KMix.Control.id
+	int32_t volume;					// percentage
+	int32_t absoluteVolume;
+	int32_t absoluteVolumeMin;
+	int32_t absoluteVolumeMax;
+	uint32_t flags;					// KMixSharedControlFlags
+	uint32_t reserved;
+};
+
+struct KMixSharedHeader
+{
+	uint32_t magic;					// KMIX_SHARED_STATE_MAGIC
+	uint32_t version;				// KMIX_SHARED_STATE_VERSION
+	uint32_t headerSize;				// sizeof(KMixSharedHeader)
+	uint32_t controlSize;				// sizeof(KMixSharedControl)
+	std::atomic<uint32_t> sequence;			// odd while being written
+	uint32_t count;					// number of valid controls
+	uint32_t flags;					// KMixSharedHeaderFlags
+	char mixerId[KMIX_SHARED_STATE_ID_LENGTH];	// as for org.kde.KMix.Mixer.id
+};
+
+struct KMixSharedState
+{
+	KMixSharedHeader header;
+	KMixSharedControl controls[KMIX_SHARED_STATE_CONTROLS];
+};
+
+/**
+ * The shm_open() name of the segment for a mixer.
+ *
+ * @param mixerPathName the last element of the D-Bus path of the mixer,
+ * for example "ALSA__Device_0" for "/Mixers/ALSA__Device_0"
+ * @param instance "kmix" for the KMix application, or "kmixd" for the
+ * KDE daemon module
+ */
+inline std::string kmixSharedStateName(const std::string &mixerPathName, const std::string &instance)
+{
+	return ('/'+instance+'-'+std::to_string(getuid())+'-'+mixerPathName);
+}
+
+
+/**
+ * Reads the state published by KMix for one mixer.
+ *
+ *   KMixSharedStateReader reader("ALSA__Device_0", "kmix");
+ *   std::vector<KMixSharedControl> controls;
+ *   if (reader.isValid() && reader.read(controls)) ...
+ *
+ * The segment is only mapped, never locked, so reading does not affect
+ * KMix at all.  If KMix restarts, the reader must be recreated.
+ */
+class KMixSharedStateReader
+{
+public:
+	KMixSharedStateReader(const std::string &mixerPathName, const std::string &instance)
+		: m_state(nullptr)
+	{
+		const int fd = shm_open(kmixSharedStateName(mixerPathName, instance).c_str(), O_RDONLY, 0);
+		if (fd<0) return;
+
+		struct stat st;
+		if (fstat(fd, &st)==0 && st.st_size>=static_cast<off_t>(sizeof(KMixSharedState)))
+		{
+			void *p = mmap(nullptr, sizeof(KMixSharedState), PROT_READ, MAP_SHARED, fd, 0);
+			if (p!=MAP_FAILED) m_state = static_cast<const KMixSharedState *>(p);
+		}
+		close(fd);
+
+		if (m_state!=nullptr &&
+		    (m_state->header.magic!=KMIX_SHARED_STATE_MAGIC ||
+		     m_state->header.version!=KMIX_SHARED_STATE_VERSION ||
+		     m_state->header.headerSize!=sizeof(KMixSharedHeader) ||
+		     m_state->header.controlSize!=sizeof(KMixSharedControl)))
+		{
+			unmap();
+		}
+	}
+
+	~KMixSharedStateReader()			{ unmap(); }
+
+	KMixSharedStateReader(const KMixSharedStateReader &) = delete;
+	KMixSharedStateReader &operator=(const KMixSharedStateReader &) = delete;
+
+	bool isValid() const				{ return (m_state!=nullptr); }
+
+	/**
+	 * The current sequence number.  If this is the same as for the
+	 * last read(), then nothing has changed since.
+	 */
+	uint32_t sequence() const
+	{
+		return (m_state!=nullptr ? m_state->header.sequence.load(std::memory_order_acquire) : 0);
+	}
+
+	/**
+	 * Copy a consistent snapshot of all controls.
+	 *
+	 * @param controls receives the controls
+	 * @param maxTries how often to retry if KMix is writing
+	 * @param truncated if not null, set to whether the mixer has more
+	 * controls than the segment can hold, which are then missing
+	 * @return @c true if a snapshot was read
+	 */
+	bool read(std::vector<KMixSharedControl> &controls, int maxTries = 100, bool *truncated = nullptr) const
+	{
+		if (m_state==nullptr) return (false);
+
+		for (int i = 0; i<maxTries; ++i)
+		{
+			const uint32_t before = m_state->header.sequence.load(std::memory_order_acquire);
+			if (before & 1) continue;			// being written
+
+			uint32_t count = m_state->header.count;
+			if (count>KMIX_SHARED_STATE_CONTROLS) count = KMIX_SHARED_STATE_CONTROLS;
+			controls.resize(count);
+			std::memcpy(controls.data(), m_state->controls, count*sizeof(KMixSharedControl));
+			const uint32_t flags = m_state->header.flags;
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (m_state->header.sequence.load(std::memory_order_relaxed)==before)
+			{
+				if (truncated!=nullptr) *truncated = (flags & KMixSharedTruncated);
+				return (true);
+			}
+		}
+		return (false);
+	}
+
+private:
+	void unmap()
+	{
+		if (m_state!=nullptr) munmap(const_cast<KMixSharedState *>(m_state), sizeof(KMixSharedState));
+		m_state = nullptr;
+	}
+
+	const KMixSharedState *m_state;
+};
+
+#endif /* KMIXSHAREDSTATE_H */
@@ -0,0 +1,295 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "core/kmixstats.h"
+
+#include <atomic>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+
+static const char *counterNames[KMixStats::CounterCount] =
+{
+	"pulse.operations",
+	"pulse.operationsFailed",
+	"dbus.signals"
+};
+
+// Indexed by the bit number of a ControlManager::ChangeType
+static const char *changeTypeNames[] = { "Volume", "ControlList", "GUI", "MasterChanged" };
+static const int changeTypeCount = sizeof(changeTypeNames)/sizeof(changeTypeNames[0]);
+
+struct MixerStats
+{
+	quint64 readSetCalls = 0;
+	quint64 readSetNsecs = 0;
+	quint64 readSetMaxNsecs = 0;
+	quint64 controlsRead = 0;
+	quint64 controlsChanged = 0;
+	quint64 writes = 0;
+	quint64 writeControls = 0;
+	quint64 writeNsecs = 0;
+	quint64 writeMaxNsecs = 0;
+};
+
+/**
+ * A histogram of latencies in the manner of HdrHistogram: the buckets
+ * are linear within each power of two, so that any value is recorded
+ * with a precision of 1/SUB_BUCKETS however large it is.
+ */
+class LatencyHistogram
+{
+	public:
+		void record(qint64 usecs)
+		{
+			const quint64 value = static_cast<quint64>(qMax(usecs, Q_INT64_C(0)));
+			++m_counts[bucketOf(value)];
+			++m_total;
+			m_max = qMax(m_max, value);
+		}
+
+		quint64 total() const				{ return (m_total); }
+		quint64 max() const				{ return (m_max); }
+
+		/// The highest value that is equivalent to the value at the percentile
+		quint64 percentile(double percent) const
+		{
+			if (m_total==0) return (0);
+			const quint64 wanted = qMax(Q_UINT64_C(1), static_cast<quint64>(m_total*percent/100.0+0.5));
+			quint64 seen = 0;
+			for (int i = 0; i<BUCKETS; ++i)
+			{
+				seen += m_counts[i];
+				if (seen>=wanted) return (qMin(highestOf(i), m_max));
+			}
+			return (m_max);
+		}
+
+	private:
+		static const int SUB_BITS = 4;
+		static const int SUB_BUCKETS = 1<<SUB_BITS;
+		static const int MAX_BITS = 40;			// about 12 days in microseconds
+		static const int BUCKETS = SUB_BUCKETS*(MAX_BITS-SUB_BITS+1);
+
+		static int bucketOf(quint64 value)
+		{
+			if (value<SUB_BUCKETS) return (static_cast<int>(value));
+			int bits = 63-__builtin_clzll(value);
+			if (bits>=MAX_BITS) return (BUCKETS-1);
+			const int shift = bits-SUB_BITS;
+			return (SUB_BUCKETS*(shift+1)+static_cast<int>((value>>shift)-SUB_BUCKETS));
+		}
+
+		static quint64 highestOf(int bucket)
+		{
+			if (bucket<SUB_BUCKETS) return (bucket);
+			const int shift = bucket/SUB_BUCKETS-1;
+			const quint64 lowest = static_cast<quint64>(SUB_BUCKETS+bucket%SUB_BUCKETS)<<shift;
+			return (lowest+(Q_UINT64_C(1)<<shift)-1);
+		}
+
+		quint64 m_counts[BUCKETS] = {};
+		quint64 m_total = 0;
+		quint64 m_max = 0;
+};
+
+static std::atomic<quint64> s_counters[KMixStats::CounterCount];
+static std::atomic<quint64> s_announceCalls[changeTypeCount];
+static std::atomic<quint64> s_announceDispatches[changeTypeCount];
+
+// Mixers may be read from several threads while they are probed
+static QMutex s_mixerMutex;
+static QHash<QString,MixerStats> s_mixerStats;
+
+// Also protected by s_mixerMutex
+static QHash<QPair<QString,QString>,qint64> s_pendingWrites;	// (mixer, control) to time requested
+// The size of s_pendingWrites, so that it can be checked without the lock
+static std::atomic<int> s_pendingCount(0);
+static QHash<QString,LatencyHistogram> s_mixerLatency;
+static QHash<QString,LatencyHistogram> s_backendLatency;
+
+static QElapsedTimer startedClock()
+{
+	QElapsedTimer clock;
+	clock.start();
+	return (clock);
+}
+
+static qint64 nowUsecs()
+{
+	static const QElapsedTimer clock = startedClock();
+	return (clock.nsecsElapsed()/1000);
+}
+
+static void insertLatency(QVariantMap &result, const QString &prefix, const LatencyHistogram &histogram)
+{
+	result.insert(prefix+"count", static_cast<qulonglong>(histogram.total()));
+	result.insert(prefix+"p50Usecs", static_cast<qulonglong>(histogram.percentile(50)));
+	result.insert(prefix+"p90Usecs", static_cast<qulonglong>(histogram.percentile(90)));
+	result.insert(prefix+"p99Usecs", static_cast<qulonglong>(histogram.percentile(99)));
+	result.insert(prefix+"p999Usecs", static_cast<qulonglong>(histogram.percentile(99.9)));
+	result.insert(prefix+"maxUsecs", static_cast<qulonglong>(histogram.max()));
+}
+
+
+void KMixStats::count(KMixStats::Counter counter)
+{
+	s_counters[counter].fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void KMixStats::readSet(const QString &mixerId, qint64 nsecs, int controlsRead, int controlsChanged)
+{
+	QMutexLocker locker(&s_mixerMutex);
+	MixerStats &stats = s_mixerStats[mixerId];
+	++stats.readSetCalls;
+	stats.readSetNsecs += nsecs;
+	stats.readSetMaxNsecs = qMax(stats.readSetMaxNsecs, static_cast<quint64>(nsecs));
+	stats.controlsRead += controlsRead;
+	stats.controlsChanged += controlsChanged;
+}
+
+
+void KMixStats::hardwareWrite(const QString &mixerId, int controls, qint64 nsecs)
+{
+	QMutexLocker locker(&s_mixerMutex);
+	MixerStats &stats = s_mixerStats[mixerId];
+	++stats.writes;
+	stats.writeControls += controls;
+	stats.writeNsecs += nsecs;
+	stats.writeMaxNsecs = qMax(stats.writeMaxNsecs, static_cast<quint64>(nsecs));
+}
+
+
+void KMixStats::announce(ControlManager::ChangeType changeType, int dispatches)
+{
+	for (int i = 0; i<changeTypeCount; ++i)
+	{
+		if (changeType!=(1<<i)) continue;
+		s_announceCalls[i].fetch_add(1, std::memory_order_relaxed);
+		s_announceDispatches[i].fetch_add(dispatches, std::memory_order_relaxed);
+		return;
+	}
+}
+
+
+void KMixStats::writeRequested(const QString &mixerId, const QString &controlId)
+{
+	const qint64 now = nowUsecs();
+	QMutexLocker locker(&s_mixerMutex);
+	// A later request replaces one that is still waiting, so that
+	// each latency is measured from the request that it confirms
+	s_pendingWrites.insert(qMakePair(mixerId, controlId), now);
+	s_pendingCount.store(s_pendingWrites.count(), std::memory_order_relaxed);
+}
+
+
+void KMixStats::writeConfirmed(const QString &mixerId, const QString &backendName, const QString &controlId)
+{
+	if (s_pendingCount.load(std::memory_order_relaxed)==0) return;	// the usual case
+
+	QMutexLocker locker(&s_mixerMutex);
+	QHash<QPair<QString,QString>,qint64>::iterator it = s_pendingWrites.find(qMakePair(mixerId, controlId));
+	if (it==s_pendingWrites.end()) return;
+
+	const qint64 latency = nowUsecs()-it.value();
+	s_pendingWrites.erase(it);
+	s_pendingCount.store(s_pendingWrites.count(), std::memory_order_relaxed);
+	s_mixerLatency[mixerId].record(latency);
+	s_backendLatency[backendName].record(latency);
+}
+
+
+void KMixStats::writesDropped(const QString &mixerId, const QString &controlId)
+{
+	if (s_pendingCount.load(std::memory_order_relaxed)==0) return;
+
+	QMutexLocker locker(&s_mixerMutex);
+	QHash<QPair<QString,QString>,qint64>::iterator it = s_pendingWrites.begin();
+	while (it!=s_pendingWrites.end())
+	{
+		if (it.key().first==mixerId && (controlId.isEmpty() || it.key().second==controlId)) it = s_pendingWrites.erase(it);
+		else ++it;
+	}
+	s_pendingCount.store(s_pendingWrites.count(), std::memory_order_relaxed);
+}
+
+
+QVariantMap KMixStats::values()
+{
+	QVariantMap result;
+
+	for (int i = 0; i<KMixStats::CounterCount; ++i)
+	{
+		result.insert(counterNames[i], static_cast<qulonglong>(s_counters[i].load()));
+	}
+
+	for (int i = 0; i<changeTypeCount; ++i)
+	{
+		const QString prefix = QString("announce.%1.").arg(changeTypeNames[i]);
+		result.insert(prefix+"calls", static_cast<qulonglong>(s_announceCalls[i].load()));
+		result.insert(prefix+"dispatches", static_cast<qulonglong>(s_announceDispatches[i].load()));
+	}
+
+	QMutexLocker locker(&s_mixerMutex);
+	for (QHash<QString,MixerStats>::const_iterator it = s_mixerStats.constBegin(); it!=s_mixerStats.constEnd(); ++it)
+	{
+		const QString prefix = QString("mixer.%1.").arg(it.key());
+		const MixerStats &stats = it.value();
+		result.insert(prefix+"readSet.calls", static_cast<qulonglong>(stats.readSetCalls));
+		result.insert(prefix+"readSet.usecs", static_cast<qulonglong>(stats.readSetNsecs/1000));
+		result.insert(prefix+"readSet.maxUsecs", static_cast<qulonglong>(stats.readSetMaxNsecs/1000));
+		result.insert(prefix+"controls.read", static_cast<qulonglong>(stats.controlsRead));
+		result.insert(prefix+"controls.changed", static_cast<qulonglong>(stats.controlsChanged));
+		result.insert(prefix+"write.calls", static_cast<qulonglong>(stats.writes));
+		result.insert(prefix+"write.controls", static_cast<qulonglong>(stats.writeControls));
+		result.insert(prefix+"write.usecs", static_cast<qulonglong>(stats.writeNsecs/1000));
+		result.insert(prefix+"write.maxUsecs", static_cast<qulonglong>(stats.writeMaxNsecs/1000));
+	}
+
+	for (QHash<QString,LatencyHistogram>::const_iterator it = s_mixerLatency.constBegin(); it!=s_mixerLatency.constEnd(); ++it)
+	{
+		insertLatency(result, QString("latency.mixer.%1.").arg(it.key()), it.value());
+	}
+	for (QHash<QString,LatencyHistogram>::const_iterator it = s_backendLatency.constBegin(); it!=s_backendLatency.constEnd(); ++it)
+	{
+		insertLatency(result, QString("latency.backend.%1.").arg(it.key()), it.value());
+	}
+
+	return (result);
+}
+
+
+void KMixStats::reset()
+{
+	for (int i = 0; i<KMixStats::CounterCount; ++i) s_counters[i] = 0;
+	for (int i = 0; i<changeTypeCount; ++i)
+	{
+		s_announceCalls[i] = 0;
+		s_announceDispatches[i] = 0;
+	}
+
+	QMutexLocker locker(&s_mixerMutex);
+	s_mixerStats.clear();
+	s_pendingWrites.clear();
+	s_pendingCount.store(0, std::memory_order_relaxed);
+	s_mixerLatency.clear();
+	s_backendLatency.clear();
+}
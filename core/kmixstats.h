@@ -0,0 +1,102 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef KMIXSTATS_H
+#define KMIXSTATS_H
+
+#include <QString>
+#include <QVariantMap>
+
+#include "core/ControlManager.h"
+#include "kmixcore_export.h"
+
+/**
+ * Counters and timers for the paths that run on every change, to find
+ * out where the time goes on a particular system.  They are always on,
+ * and only cost an atomic increment or an uncontended lock each.
+ *
+ * The values are published over D-Bus by DBusStatsWrapper, and shown
+ * by "kmixctrl --stats".
+ */
+class KMIXCORE_EXPORT KMixStats
+{
+	public:
+		/// Counters which are not for a particular mixer
+		enum Counter
+		{
+			PulseOperations,
+			PulseOperationsFailed,
+			DBusSignals,
+			CounterCount
+		};
+
+		static void count(KMixStats::Counter counter);
+
+		/**
+		 * Record a Mixer_Backend::readSetFromHW().
+		 *
+		 * @param nsecs how long it took
+		 * @param controlsRead how many controls were read
+		 * @param controlsChanged how many of them had changed
+		 */
+		static void readSet(const QString &mixerId, qint64 nsecs, int controlsRead, int controlsChanged);
+
+		/**
+		 * Record a write of one or more controls to the hardware.
+		 */
+		static void hardwareWrite(const QString &mixerId, int controls, qint64 nsecs);
+
+		/**
+		 * Record a ControlManager::announce().
+		 *
+		 * @param dispatches how many listeners were notified
+		 */
+		static void announce(ControlManager::ChangeType changeType, int dispatches);
+
+		/**
+		 * Record that a new value for a control has been requested,
+		 * to measure the time until the hardware confirms it.
+		 */
+		static void writeRequested(const QString &mixerId, const QString &controlId);
+
+		/**
+		 * Record that the hardware has reported the value of a control.
+		 * If a write to it was waiting, the time since it was requested
+		 * is added to the latency histograms of the mixer and the backend.
+		 */
+		static void writeConfirmed(const QString &mixerId, const QString &backendName, const QString &controlId);
+
+		/**
+		 * Forget any write that is waiting to be confirmed for a control
+		 * which has gone, or for all controls of the mixer if @p controlId
+		 * is empty.
+		 */
+		static void writesDropped(const QString &mixerId, const QString &controlId = QString());
+
+		/**
+		 * All of the values, with a name such as
+		 * "mixer.<id>.readSet.calls" or "announce.Volume.dispatches".
+		 * Times are in microseconds.  The latency histograms are
+		 * given as percentiles, e.g. "latency.backend.ALSA.p99Usecs".
+		 */
+		static QVariantMap values();
+
+		static void reset();
+};
+
+#endif /* KMIXSTATS_H */
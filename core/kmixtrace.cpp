@@ -0,0 +1,176 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "core/kmixtrace.h"
+
+#include <atomic>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+
+#include "kmix_debug.h"
+
+// The number of events kept, the oldest are overwritten after that
+#define MAX_EVENTS 200000
+
+struct TraceEvent
+{
+	const char *name;
+	const char *category;
+	QString detail;
+	qint64 start;				// nanoseconds
+	qint64 duration;			// -1 for an instant event
+	quintptr thread;
+};
+
+static std::atomic<bool> s_enabled(false);
+
+// Backend events may be recorded in other threads
+static QMutex s_mutex;
+static QVector<TraceEvent> s_events;
+static int s_next = 0;				// where to record when the buffer is full
+
+static QElapsedTimer startedClock()
+{
+	QElapsedTimer clock;
+	clock.start();
+	return (clock);
+}
+
+static qint64 now()
+{
+	static const QElapsedTimer clock = startedClock();
+	return (clock.nsecsElapsed());
+}
+
+static void record(const char *name, const char *category, const QString &detail, qint64 start, qint64 duration)
+{
+	const TraceEvent event = { name, category, detail, start, duration,
+				   reinterpret_cast<quintptr>(QThread::currentThreadId()) };
+
+	QMutexLocker locker(&s_mutex);
+	if (s_events.count()<MAX_EVENTS) s_events.append(event);
+	else
+	{
+		s_events[s_next] = event;
+		s_next = (s_next+1) % MAX_EVENTS;
+	}
+}
+
+
+KMixTrace::Span::Span(const char *name, const char *category, const QString &detail)
+	: m_name(name),
+	  m_category(category),
+	  m_start(-1)
+{
+	if (!KMixTrace::isEnabled()) return;
+	m_detail = detail;
+	m_start = now();
+}
+
+
+KMixTrace::Span::~Span()
+{
+	if (m_start<0 || !KMixTrace::isEnabled()) return;
+	record(m_name, m_category, m_detail, m_start, now()-m_start);
+}
+
+
+void KMixTrace::instant(const char *name, const char *category, const QString &detail)
+{
+	if (!KMixTrace::isEnabled()) return;
+	record(name, category, detail, now(), -1);
+}
+
+
+bool KMixTrace::isEnabled()
+{
+	return (s_enabled.load(std::memory_order_relaxed));
+}
+
+
+void KMixTrace::setEnabled(bool enabled)
+{
+	if (enabled==isEnabled()) return;
+	qCDebug(KMIX_LOG) << "Tracing" << (enabled ? "started" : "stopped");
+
+	if (enabled)
+	{
+		QMutexLocker locker(&s_mutex);
+		s_events.clear();
+		s_next = 0;
+	}
+	s_enabled = enabled;
+}
+
+
+bool KMixTrace::write(const QString &fileName)
+{
+	const qint64 pid = QCoreApplication::applicationPid();
+	QJsonArray traceEvents;
+
+	{
+		QMutexLocker locker(&s_mutex);
+		for (int i = 0; i<s_events.count(); ++i)
+		{
+			// Oldest first, so that the viewer does not need to sort
+			const TraceEvent &event = s_events.at((s_next+i) % s_events.count());
+
+			QJsonObject obj;
+			obj.insert("name", QString::fromLatin1(event.name));
+			obj.insert("cat", QString::fromLatin1(event.category));
+			obj.insert("pid", pid);
+			obj.insert("tid", static_cast<qint64>(event.thread));
+			obj.insert("ts", event.start/1000.0);		// microseconds
+			if (event.duration<0)
+			{
+				obj.insert("ph", QStringLiteral("i"));
+				obj.insert("s", QStringLiteral("t"));
+			}
+			else
+			{
+				obj.insert("ph", QStringLiteral("X"));
+				obj.insert("dur", event.duration/1000.0);
+			}
+			if (!event.detail.isEmpty()) obj.insert("args", QJsonObject({ { "detail", event.detail } }));
+			traceEvents.append(obj);
+		}
+	}
+
+	QJsonObject trace;
+	trace.insert("traceEvents", traceEvents);
+	trace.insert("displayTimeUnit", QStringLiteral("ms"));
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly|QIODevice::Truncate))
+	{
+		qCWarning(KMIX_LOG) << "Cannot write trace to" << fileName << file.errorString();
+		return (false);
+	}
+
+	file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+	qCDebug(KMIX_LOG) << "Wrote" << traceEvents.count() << "trace events to" << fileName;
+	return (true);
+}
@@ -0,0 +1,82 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef KMIXTRACE_H
+#define KMIXTRACE_H
+
+#include <QString>
+
+#include "kmixcore_export.h"
+
+/**
+ * Records timestamped spans along the path of a change, from the backend
+ * event to the GUI update and the D-Bus signal, to be written out in the
+ * Chrome trace event format and viewed in chrome://tracing or Perfetto.
+ *
+ * Tracing is off unless the DebugTrace setting is set or it is started
+ * over D-Bus (see "kmixctrl --trace-start").  When it is off, a span
+ * costs a single check.  The most recent events are kept, up to a limit,
+ * until the trace is written.
+ */
+class KMIXCORE_EXPORT KMixTrace
+{
+	public:
+		/**
+		 * A span of time, from construction to destruction.
+		 *
+		 * @param name the name of the span, which must be a literal
+		 * @param category the category, which must be a literal
+		 * @param detail more information, such as a mixer or control ID
+		 */
+		class KMIXCORE_EXPORT Span
+		{
+			public:
+				Span(const char *name, const char *category, const QString &detail = QString());
+				~Span();
+
+			private:
+				Q_DISABLE_COPY(Span)
+
+				const char *m_name;
+				const char *m_category;
+				QString m_detail;
+				qint64 m_start;			// -1 if not tracing
+		};
+
+		/**
+		 * Record an event that has no duration.
+		 */
+		static void instant(const char *name, const char *category, const QString &detail = QString());
+
+		static bool isEnabled();
+
+		/**
+		 * Start or stop recording.  Starting discards any events
+		 * that have already been recorded.
+		 */
+		static void setEnabled(bool enabled);
+
+		/**
+		 * Write the events that have been recorded as a JSON trace.
+		 *
+		 * @return @c true if the file was written
+		 */
+		static bool write(const QString &fileName);
+};
+
+#endif /* KMIXTRACE_H */
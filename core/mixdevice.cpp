@@ -26,7 +26,6 @@
 #include <klocalizedstring.h>
 
 #include "core/mixer.h"
-#include "dbus/dbuscontrolwrapper.h"
 #include "gui/guiprofile.h"
 #include "core/volume.h"
 
@@ -115,7 +114,6 @@ void MixDevice::init(  Mixer* mixer, const QString& id, const QString& name, con
 {
     _artificial = false;
     _applicationStream = false;
-    _dbusControlWrapper = nullptr;			// will be set in addToPool()
     _mixer = mixer;
     _id = id;
     _enumCurrentId = 0;
@@ -139,25 +137,12 @@ void MixDevice::init(  Mixer* mixer, const QString& id, const QString& name, con
 }
 
 
-/*
- * When a MixDevice shall be finally discarded, you must use this method to free its resources.
- * You must not use this MixDevice after calling close().
- * <br>
- * The necessity stems from a memory leak due to object cycle (MixDevice<->DBusControlWrapper), so the reference
- * counting shared_ptr has no chance to clean up. See Bug 309464 for background information.
- */
-void MixDevice::close()
-{
-	delete _dbusControlWrapper;
-	_dbusControlWrapper = nullptr;
-}
-
-
 shared_ptr<MixDevice> MixDevice::addToPool()
 {
 //	qCDebug(KMIX_LOG) << "id=" <<  _mixer->id() << ":" << _id;
+    // No D-Bus object is registered here, the mixer's DBusMixerObject
+    // serves dbusPath() on demand.
     shared_ptr<MixDevice> thisSharedPtr(this);
-    _dbusControlWrapper = new DBusControlWrapper(thisSharedPtr, dbusPath());
     return (thisSharedPtr);
 }
 
@@ -267,7 +252,6 @@ void MixDevice::addEnums(QList<QString*>& ref_enumList)
 MixDevice::~MixDevice()
 {
     _enumValues.clear(); // The QString's inside will be auto-deleted, as they get unref'ed
-    delete _dbusControlWrapper;
     delete _mediaController;
 }
 
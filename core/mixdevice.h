@@ -37,8 +37,6 @@ class ProfControl;
 #include "core/volume.h"
 #include "kmixcore_export.h"
 
-class DBusControlWrapper;
-
 // KDE
 #include <kconfig.h>
 #include <kconfiggroup.h>
@@ -115,8 +113,6 @@ public:
    MixDevice(Mixer* mixer, const QString& id, const QString& name, const QString& iconName = "", MixSet* moveDestinationMixSet = nullptr);
    virtual ~MixDevice();
 
-   void close();
-
    shared_ptr<MixDevice> addToPool();
 
    const QString &iconName() const			{ return (_iconName); }
@@ -223,7 +219,6 @@ private:
    int _enumCurrentId;
    QStringList _enumValues; // A MixDevice, that is an ENUM, has these _enumValues
 
-   DBusControlWrapper *_dbusControlWrapper;
    MediaController* _mediaController;
 
    // A virtual control. It will not be saved/restored and/or doesn't get shortcuts
@@ -25,17 +25,24 @@
 #include <klocalizedstring.h>
 #include <kconfig.h>
 
+#include <QElapsedTimer>
+
 #include "settings.h"
 #include "backends/mixer_backend.h"
 #include "backends/kmix-backends.cpp"
+#include "backends/pollscheduler.h"
 #include "core/ControlManager.h"
+#include "core/kmixstats.h"
+#include "core/mixerstateexport.h"
 #include "core/volume.h"
+#include "core/volumesnapshot.h"
 
 /**
  * Some general design hints. Hierarchy is Mixer->MixDevice->Volume
  */
 
 QList<Mixer *> Mixer::s_mixers;
+bool Mixer::s_publishing = true;
 MasterControl Mixer::_globalMasterCurrent;
 MasterControl Mixer::_globalMasterPreferred;
 
@@ -85,7 +92,8 @@ MasterControl Mixer::_globalMasterPreferred;
 
 Mixer::Mixer(const QString &ref_driverName, int device)
     : m_balance(0),
-      m_dynamic(false)
+      m_dynamic(false),
+      m_probed(false)
 {
     _mixerBackend = nullptr;
     const int driverCount = numDrivers();
@@ -112,6 +120,11 @@ Mixer::~Mixer()
 {
    // Close the mixer. This might also free memory, depending on the called backend method
    close();
+   if (_mixerBackend==nullptr) return;
+
+   // The backend is only deleted later, so it must not refer to this
+   // Mixer meanwhile
+   _mixerBackend->_mixer = nullptr;
    _mixerBackend->deleteLater();
 }
 
@@ -197,44 +210,127 @@ const QString Mixer::dbusPath()
 
 void Mixer::volumeSave(KConfig *config) const
 {
-    //    qCDebug(KMIX_LOG) << "Mixer::volumeSave()";
-    _mixerBackend->readSetFromHW();
-    QString grp("Mixer");
-    grp.append(id());
-    _mixerBackend->m_mixDevices.write( config, grp );
+    volumeSaveAll(config, QList<Mixer *>() << const_cast<Mixer *>(this));
+}
+
+/**
+ * Save the volumes of several mixers, as for volumeSave().  The config
+ * and the snapshot are each written only once for all of them.
+ */
+void Mixer::volumeSaveAll(KConfig *config, const QList<Mixer *> &mixers)
+{
+    QList<const Mixer *> snapshotMixers;
+    for (const Mixer *mixer : mixers)
+    {
+        //    qCDebug(KMIX_LOG) << "Mixer::volumeSave()";
+        mixer->_mixerBackend->readSetFromHW();
+        QString grp("Mixer");
+        grp.append(mixer->id());
+        mixer->_mixerBackend->m_mixDevices.write( config, grp );
+        if (!mixer->isDynamic()) snapshotMixers.append(mixer);
+    }
 
     // This might not be the standard application config object
     // => Better be safe and call sync().
     config->sync();
+
+    // Also save the binary snapshot that volumeLoad() prefers.
+    // The config file is still written, as the fallback.
+    if (!snapshotMixers.isEmpty()) VolumeSnapshot::save(config->name(), snapshotMixers);
 }
 
-void Mixer::volumeLoad(const KConfig *config)
+/**
+ * The state of a control that is saved and restored,
+ * for finding out which controls a restore changes.
+ */
+struct RestoredState
+{
+   explicit RestoredState(const shared_ptr<MixDevice> &md)
+      : muted(md->isMuted()),
+        recSource(md->isRecSource()),
+        enumId(md->isEnum() ? md->enumId() : 0)
+   {
+      for (const VolumeChannel &vc : md->playbackVolume().getVolumes()) playback.append(vc.volume);
+      for (const VolumeChannel &vc : md->captureVolume().getVolumes()) capture.append(vc.volume);
+   }
+
+   bool operator==(const RestoredState &other) const
+   {
+      return (playback==other.playback && capture==other.capture &&
+              muted==other.muted && recSource==other.recSource && enumId==other.enumId);
+   }
+
+   QList<long> playback;
+   QList<long> capture;
+   bool muted;
+   bool recSource;
+   unsigned int enumId;
+};
+
+/**
+ * Restore the saved volumes.  The current state is read from the hardware
+ * first, and only the controls that differ from the saved state are written.
+ *
+ * @param announce if @c false, the changes are written to the backend without
+ * reading back or announcing them.  This is only for restoring when nothing
+ * else is using the mixer, and allows mixers to be restored in parallel.
+ * @return the IDs of the controls that were changed
+ */
+QStringList Mixer::volumeLoad(const KConfig *config, bool announce)
 {
+   QStringList changedIds;
+
+   VolumeSnapshot snapshot(config->name());
+   const bool useSnapshot = !isDynamic() && snapshot.open() && snapshot.hasMixer(id());
    QString grp("Mixer");
    grp.append(id());
-   if ( ! config->hasGroup(grp) ) {
+   if ( !useSnapshot && ! config->hasGroup(grp) ) {
       // no such group. Volumes (of this mixer) were never saved beforehand.
       // Thus don't restore anything (also see Bug #69320 for understanding the real reason)
-      return; // make sure to bail out immediately
+      return (changedIds); // make sure to bail out immediately
    }
 
-   // else restore the volumes
-   if ( ! _mixerBackend->m_mixDevices.read( config, grp ) ) {
-      // Some mixer backends don't support reading the volume into config
-      // files, so bail out early if that's the case.
-      return;
+   // Find out what the hardware has now
+   QList<RestoredState> before;
+   for (const shared_ptr<MixDevice> &md : qAsConst(_mixerBackend->m_mixDevices))
+   {
+      _mixerBackend->readVolumeFromHW(md->id(), md);
+      if (md->isEnum()) md->setEnumId(_mixerBackend->enumIdHW(md->id()));
+      before.append(RestoredState(md));
+   }
+
+   if (useSnapshot)
+   {
+      // Fast path, restore from the binary snapshot
+      if (!snapshot.restore(id(), _mixerBackend->m_mixDevices)) return (changedIds);
+   }
+   else
+   {
+      // Fall back to the config file, e.g. if the volumes were saved
+      // by an older version that did not write a snapshot
+      if ( ! _mixerBackend->m_mixDevices.read( config, grp ) ) {
+         // Some mixer backends don't support reading the volume into config
+         // files, so bail out early if that's the case.
+         return (changedIds);
+      }
    }
 
-   // set new settings
+   // Write only what is different, all in one go
+   QList<shared_ptr<MixDevice> > changed;
    for (int i = 0; i<_mixerBackend->m_mixDevices.count(); ++i)
    {
-	   shared_ptr<MixDevice> md = _mixerBackend->m_mixDevices[i];
-	   if (!md) continue;
+      shared_ptr<MixDevice> md = _mixerBackend->m_mixDevices[i];
+      if (RestoredState(md)==before.at(i)) continue;
 
-       _mixerBackend->writeVolumeToHW( md->id(), md );
-       if ( md->isEnum() )
-    	   _mixerBackend->setEnumIdHW( md->id(), md->enumId() );
+      changed.append(md);
+      changedIds.append(md->id());
    }
+
+   qCDebug(KMIX_LOG) << "Restored" << changed.count() << "of" << _mixerBackend->m_mixDevices.count()
+                     << "controls of" << id() << changedIds;
+   if (announce) commitVolumeChanges(changed);
+   else if (!changed.isEmpty()) writeVolumesToHW(changed);
+   return (changedIds);
 }
 
 
@@ -253,8 +349,9 @@ bool Mixer::openIfValid()
         return false;
     }
 
-    bool ok = _mixerBackend->openIfValid();
-    if (!ok) return (false);
+    // The backend may already have been opened by probe()
+    if (!m_probed && !_mixerBackend->probe()) return (false);
+    _mixerBackend->startPolling();
 
     recreateId();
     shared_ptr<MixDevice> recommendedMaster = _mixerBackend->recommendedMaster();
@@ -272,17 +369,48 @@ bool Mixer::openIfValid()
         setLocalMasterMD(noMaster); // no master
     }
 
-    new DBusMixerWrapper(this, dbusPath());
+    if (s_publishing)
+    {
+        new DBusMixerWrapper(this, dbusPath());
+        if (Settings::exportSharedState()) new MixerStateExport(this);
+    }
     return (true);
 }
 
 
+bool Mixer::probe()
+{
+    if (_mixerBackend==nullptr) return (false);
+    m_probed = _mixerBackend->probe();
+    return (m_probed);
+}
+
+
 /**
- * Closes the mixer.
+ * Move the mixer, its backend and its controls to another thread.
+ * QObject::moveToThread() can only push an object away from the
+ * current thread, so this must be called in the thread that created
+ * the mixer.
+ */
+void Mixer::moveProbedToThread(QThread *thread)
+{
+    moveToThread(thread);
+    if (_mixerBackend==nullptr) return;
+
+    _mixerBackend->moveToThread(thread);
+    for (const shared_ptr<MixDevice> &md : qAsConst(_mixerBackend->m_mixDevices)) md->moveToThread(thread);
+}
+
+
+/**
+ * Closes the mixer.  Writes to its controls that have not been confirmed
+ * yet are dropped here, while the mixer ID is still valid.
  */
 void Mixer::close()
 {
-    if (_mixerBackend!=nullptr) _mixerBackend->closeCommon();
+    if (_mixerBackend==nullptr) return;
+    _mixerBackend->closeCommon();
+    KMixStats::writesDropped(id());
 }
 
 
@@ -333,7 +461,7 @@ void Mixer::setBalance(int balance)
    Volume& volC = master->captureVolume();
    setBalanceInternal(volC);
 
-   _mixerBackend->writeVolumeToHW( master->id(), master );
+   writeVolumesToHW(QList<shared_ptr<MixDevice> >() << master);
    emit newBalance( volP );
 }
 
@@ -544,14 +672,50 @@ shared_ptr<MixDevice> Mixer::getMixdeviceById(const QString& mixdeviceID) const
    - It is fast               (no copying of Volume objects required)
    - It is easy to understand ( read - modify - commit )
 */
+/**
+ * Write controls to the hardware, keeping count of the writes and
+ * how long they take.  The time until the hardware confirms each
+ * control is measured from here, see KMixStats::writeRequested().
+ */
+QList<int> Mixer::writeVolumesToHW(const QList<shared_ptr<MixDevice> > &mds)
+{
+	for (const shared_ptr<MixDevice> &md : mds) KMixStats::writeRequested(id(), md->id());
+
+	QElapsedTimer timer;
+	timer.start();
+	const QList<int> results = _mixerBackend->writeVolumesToHW(mds);
+	KMixStats::hardwareWrite(id(), mds.count(), timer.nsecsElapsed());
+	return (results);
+}
+
 void Mixer::commitVolumeChange(shared_ptr<MixDevice> md)
 {
-	_mixerBackend->writeVolumeToHW(md->id(), md);
-	if (md->isEnum())
+	commitVolumeChanges(QList<shared_ptr<MixDevice> >() << md);
+}
+
+/**
+ * Commit the changed state of a number of controls to the hardware,
+ * with a single backend write and a single announcement.
+ *
+ * @param mds the controls, all of which must belong to this mixer
+ * @return the result (a MixerError) of writing each control, in the order of @p mds
+ */
+QList<int> Mixer::commitVolumeChanges(const QList<shared_ptr<MixDevice> > &mds)
+{
+	if (mds.isEmpty()) return (QList<int>());
+
+	const QList<int> results = writeVolumesToHW(mds);
+
+	// The user is changing controls, so look out for the effects of that
+	if (_mixerBackend->needsPolling()) PollScheduler::instance()->promote(_mixerBackend);
+
+	bool hasCaptureSwitch = false;
+	for (const shared_ptr<MixDevice> &md : mds)
 	{
-		_mixerBackend->setEnumIdHW(md->id(), md->enumId());
+		if (md->captureVolume().hasSwitch()) hasCaptureSwitch = true;
 	}
-	if (md->captureVolume().hasSwitch())
+
+	if (hasCaptureSwitch)
 	{
 		// Make sure to re-read the hardware, because setting capture might have failed.
 		// This is due to exclusive capture groups.
@@ -563,16 +727,22 @@ void Mixer::commitVolumeChange(shared_ptr<MixDevice> md)
 		_mixerBackend->readSetFromHWforceUpdate();
 		if (Settings::debugControlManager())
 			qCDebug(KMIX_LOG)
-			<< "committing a control with capture volume, that might announce: " << md->id();
+			<< "committing a control with capture volume, that might announce: " << mds.first()->id();
+		//
+		// This read follows the write straight away, so it says nothing
+		// about how long the hardware takes to confirm the write.
+		_mixerBackend->_readConfirmsWrites = false;
 		_mixerBackend->readSetFromHW();
+		_mixerBackend->_readConfirmsWrites = true;
 	}
 	if (Settings::debugControlManager())
 		qCDebug(KMIX_LOG)
-		<< "committing announces the change of: " << md->id();
+		<< "committing announces the change of: " << mds.first()->id() << "and" << (mds.count()-1) << "more";
 
 	// We announce the change we did, so all other parts of KMix can pick up the change
-	ControlManager::instance().announce(md->mixer()->id(), ControlManager::Volume,
+	ControlManager::instance().announce(id(), ControlManager::Volume,
 		QString("Mixer.commitVolumeChange()"));
+	return (results);
 }
 
 // @dbus, used also in kmix app
@@ -612,7 +782,7 @@ void Mixer::increaseOrDecreaseVolume( const QString& mixdeviceID, bool decrease
            volC.changeAllVolumes(volC.volumeStep(decrease));
         }
 
-        _mixerBackend->writeVolumeToHW(mixdeviceID, md);
+        writeVolumesToHW(QList<shared_ptr<MixDevice> >() << md);
     }
    ControlManager::instance().announce(md->mixer()->id(), ControlManager::Volume, QString("Mixer.increaseOrDecreaseVolume()"));
 
@@ -29,6 +29,7 @@
 #include <QList>
 #include <QObject>
 #include <QString>
+#include <QStringList>
 
 #include "core/volume.h"
 #include "backends/mixer_backend.h"
@@ -45,6 +46,8 @@ class KMIXCORE_EXPORT Mixer : public QObject
 {
       Q_OBJECT
 
+      friend class TopologyCache;
+
 public:
 	/**
 	 * Status for Mixer operations.
@@ -64,12 +67,14 @@ public:
 
     static int numDrivers();
     QString getDriverName() const		{ return (_mixerBackend->getDriverName()); }
+    QString driverVersion() const		{ return (_mixerBackend->driverVersion()); }
 
     shared_ptr<MixDevice> find(const QString &devPK) const;
     static Mixer* findMixer(const QString &mixer_id);
 
     void volumeSave(KConfig *config) const;
-    void volumeLoad(const KConfig *config);
+    static void volumeSaveAll(KConfig *config, const QList<Mixer *> &mixers);
+    QStringList volumeLoad(const KConfig *config, bool announce = true);
 
     /// How many mixer backend devices
     unsigned int size() const			{ return (_mixerBackend->m_mixDevices.count()); }
@@ -82,6 +87,15 @@ public:
     /// Open/grab the mixer for further interaction
     bool openIfValid();
 
+    /**
+     * Open the mixer and check whether it is valid, without starting
+     * to use it.  This may be called in a worker thread, which must then
+     * move the mixer with moveProbedToThread() before openIfValid() is
+     * called in the main thread to finish opening it.
+     */
+    bool probe();
+    void moveProbedToThread(QThread *thread);
+
     /// Returns whether the card is open/operational
     bool isOpen() const;
 
@@ -124,6 +138,8 @@ public:
     const QString &id() const			{ return (_id); }
 
     int getCardInstance() const      		{ return _mixerBackend->getCardInstance(); }
+    /// The device number that the mixer was created with
+    int deviceNumber() const			{ return (_mixerBackend->m_devnum); }
 
     /// Returns an Universal Device Identification of the Mixer. This is an ID that relates to the underlying operating system.
     // For OSS and ALSA this is taken from Solid (actually HAL). For Solaris this is just the device name.
@@ -139,6 +155,13 @@ public:
 
     static QList<Mixer *> &mixers();
 
+    /**
+     * Whether mixers are published on D-Bus (and in shared memory, if
+     * configured) when they are opened.  The default is @c true, tools
+     * that only save or restore volumes can turn it off.
+     */
+    static void setPublishing(bool publish)	{ s_publishing = publish; }
+
     /******************************************
     The KMix GLOBAL master card. Please note that KMix and KMixPanelApplet can have a
     different MasterCard's at the moment (but actually KMixPanelApplet does not read/save this yet).
@@ -185,6 +208,7 @@ public:
     virtual int mediaNext(QString id)		{ return _mixerBackend->mediaNext(id); }
 
     void commitVolumeChange( shared_ptr<MixDevice> md );
+    QList<int> commitVolumeChanges(const QList<shared_ptr<MixDevice> > &mds);
 
 public slots:
     void readSetFromHWforceUpdate() const;
@@ -197,17 +221,20 @@ signals:
 
 protected:
     static QList<Mixer *> s_mixers;
+    static bool s_publishing;
 
 private:
     void setBalanceInternal(Volume& vol);
     void recreateId();
     void increaseOrDecreaseVolume( const QString& mixdeviceID, bool decrease );
+    QList<int> writeVolumesToHW(const QList<shared_ptr<MixDevice> > &mds);
 
     Mixer_Backend *_mixerBackend;
     QString _id;
     QString _masterDevicePK;
     int m_balance; // from -100 (just left) to 100 (just right)
     bool m_dynamic;
+    bool m_probed;
 
     static MasterControl _globalMasterCurrent;
     static MasterControl _globalMasterPreferred;
@@ -0,0 +1,163 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "core/mixerstateexport.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include "core/kmixsharedstate.h"
+#include "core/mixer.h"
+#include "core/volume.h"
+#include "kmix_debug.h"
+
+
+QString MixerStateExport::s_instanceName = QStringLiteral("kmix");
+
+
+void MixerStateExport::setInstanceName(const QString &name)
+{
+	s_instanceName = name;
+}
+
+
+MixerStateExport::MixerStateExport(Mixer *mixer)
+	: QObject(mixer),
+	  m_mixer(mixer),
+	  m_state(nullptr),
+	  m_truncated(false)
+{
+	const QString pathName = mixer->dbusPath().section('/', -1);
+	m_name = QByteArray::fromStdString(kmixSharedStateName(pathName.toStdString(),
+								       s_instanceName.toStdString()));
+
+	// Any segment left over from a previous run of this instance is
+	// replaced, readers still mapping that will see its last state.
+	shm_unlink(m_name.constData());
+	const int fd = shm_open(m_name.constData(), O_RDWR|O_CREAT|O_EXCL, S_IRUSR|S_IWUSR);
+	if (fd<0)
+	{
+		qCWarning(KMIX_LOG) << "Cannot create shared state" << m_name << strerror(errno);
+		return;
+	}
+
+	if (ftruncate(fd, sizeof(KMixSharedState))==0)
+	{
+		void *p = mmap(nullptr, sizeof(KMixSharedState), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+		if (p!=MAP_FAILED) m_state = static_cast<KMixSharedState *>(p);
+	}
+	::close(fd);
+
+	if (m_state==nullptr)
+	{
+		qCWarning(KMIX_LOG) << "Cannot map shared state" << m_name << strerror(errno);
+		shm_unlink(m_name.constData());
+		return;
+	}
+
+	// The new segment is zero filled, so the sequence starts even
+	KMixSharedHeader &header = m_state->header;
+	header.magic = KMIX_SHARED_STATE_MAGIC;
+	header.version = KMIX_SHARED_STATE_VERSION;
+	header.headerSize = sizeof(KMixSharedHeader);
+	header.controlSize = sizeof(KMixSharedControl);
+	qstrncpy(header.mixerId, mixer->id().toUtf8().constData(), sizeof(header.mixerId));
+	update();
+
+	qCDebug(KMIX_LOG) << "Exporting state of" << mixer->id() << "as" << m_name;
+	ControlManager::instance().addListener(mixer->id(),
+					       ControlManager::ControlList|ControlManager::Volume,
+					       this, QString("MixerStateExport.%1").arg(mixer->id()));
+}
+
+
+MixerStateExport::~MixerStateExport()
+{
+	ControlManager::instance().removeListener(this);
+	if (m_state==nullptr) return;
+
+	munmap(m_state, sizeof(KMixSharedState));
+	shm_unlink(m_name.constData());
+}
+
+
+void MixerStateExport::controlsChange(ControlManager::ChangeType changeType)
+{
+	switch (changeType)
+	{
+case ControlManager::ControlList:
+case ControlManager::Volume:
+		update();
+		break;
+
+default:
+		ControlManager::warnUnexpectedChangeType(changeType, this);
+		break;
+	}
+}
+
+
+/**
+ * Write the current state of all controls into the segment,
+ * following the sequence lock protocol.
+ */
+void MixerStateExport::update()
+{
+	if (m_state==nullptr) return;
+
+	KMixSharedHeader &header = m_state->header;
+	header.sequence.fetch_add(1, std::memory_order_relaxed);		// now odd
+	std::atomic_thread_fence(std::memory_order_release);
+
+	const MixSet &mixSet = m_mixer->getMixSet();
+	uint32_t count = 0;
+	for (const shared_ptr<MixDevice> md : qAsConst(mixSet))
+	{
+		if (count>=KMIX_SHARED_STATE_CONTROLS) break;
+
+		const Volume &useVolume = (md->playbackVolume().count() != 0) ? md->playbackVolume() : md->captureVolume();
+		const qreal avgVol = useVolume.getAvgVolume(Volume::MALL);
+
+		KMixSharedControl &control = m_state->controls[count++];
+		qstrncpy(control.id, md->id().toUtf8().constData(), sizeof(control.id));
+		control.volume = useVolume.getAvgVolumePercent(Volume::MALL);
+		control.absoluteVolume = static_cast<int32_t>(avgVol <0 ? avgVol-.5 : avgVol+.5);
+		control.absoluteVolumeMin = static_cast<int32_t>(useVolume.minVolume());
+		control.absoluteVolumeMax = static_cast<int32_t>(useVolume.maxVolume());
+		control.flags = 0;
+		if (md->isMuted()) control.flags |= KMixSharedMuted;
+		if (md->isRecSource()) control.flags |= KMixSharedRecordSource;
+		if (md->hasMuteSwitch()) control.flags |= KMixSharedCanMute;
+		if (md->captureVolume().hasSwitch()) control.flags |= KMixSharedHasCaptureSwitch;
+	}
+	header.count = count;
+
+	// Readers see that the table is incomplete from the flag
+	const bool truncated = (mixSet.count()>KMIX_SHARED_STATE_CONTROLS);
+	header.flags = (truncated ? KMixSharedTruncated : 0);
+
+	std::atomic_thread_fence(std::memory_order_release);
+	header.sequence.fetch_add(1, std::memory_order_relaxed);		// even again
+
+	if (truncated && !m_truncated)
+	{
+		qCWarning(KMIX_LOG) << "Only exporting" << KMIX_SHARED_STATE_CONTROLS << "of the"
+				    << mixSet.count() << "controls of" << m_mixer->id();
+	}
+	m_truncated = truncated;
+}
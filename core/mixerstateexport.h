@@ -0,0 +1,70 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef MIXERSTATEEXPORT_H
+#define MIXERSTATEEXPORT_H
+
+#include <QObject>
+#include <QByteArray>
+
+#include "core/ControlManager.h"
+#include "kmixcore_export.h"
+
+class Mixer;
+struct KMixSharedState;
+
+/**
+ * Publishes the state of the controls of a mixer in a shared memory
+ * segment, so that local clients can read it without D-Bus.  The layout
+ * of the segment and a reader are in kmixsharedstate.h.
+ *
+ * Created by Mixer::openIfValid() if the ExportSharedState setting is on.
+ */
+class KMIXCORE_EXPORT MixerStateExport : public QObject
+{
+	Q_OBJECT
+
+	public:
+		explicit MixerStateExport(Mixer *mixer);
+		~MixerStateExport();
+
+		/**
+		 * Set the instance part of the segment names, "kmix" for
+		 * the application or "kmixd" for the KDE daemon module, so
+		 * that both can export at the same time.  This must be done
+		 * before any mixers are opened.
+		 */
+		static void setInstanceName(const QString &name);
+
+		bool isValid() const				{ return (m_state!=nullptr); }
+
+	public slots:
+		void controlsChange(ControlManager::ChangeType changeType);
+
+	private:
+		void update();
+
+		static QString s_instanceName;
+
+		Mixer *m_mixer;
+		QByteArray m_name;
+		KMixSharedState *m_state;
+		bool m_truncated;				// warned that not all controls fit
+};
+
+#endif /* MIXERSTATEEXPORT_H */
@@ -22,15 +22,24 @@
 #include "core/mixertoolbox.h"
 #include "core/mixer.h"
 
+#include <QCoreApplication>
 #include <QDir>
 #include <QWidget>
+#include <QRunnable>
 #include <QString>
 #include <QStringBuilder>
+#include <QThreadPool>
+
+#include <vector>
 
 #include <klocalizedstring.h>
 
 #include "core/kmixdevicemanager.h"
 #include "core/mixdevice.h"
+#include "core/volumesnapshot.h"
+#ifdef HAVE_EPOLL
+#include "backends/fdreactor.h"
+#endif
 
 
 static QRegExp s_ignoreMixerExpression(QStringLiteral("Modem"));
@@ -48,6 +57,38 @@ namespace MixerToolBox
 
 enum MultiDriverMode { SINGLE, SINGLE_PLUS_MPRIS2, MULTI };
 
+
+struct ProbeResult
+{
+    Mixer *mixer;
+    bool valid;
+};
+
+/**
+ * Create and probe one mixer in a worker thread.  The mixer is always
+ * handed back to the main thread, so that it can be used or deleted there.
+ */
+class ProbeJob : public QRunnable
+{
+public:
+    ProbeJob(const QString &driverName, int dev, ProbeResult *result)
+        : m_driverName(driverName), m_dev(dev), m_result(result)	{}
+
+    void run() override
+    {
+        Mixer *mixer = new Mixer(m_driverName, m_dev);
+        m_result->valid = mixer->probe();
+        mixer->moveProbedToThread(QCoreApplication::instance()->thread());
+        m_result->mixer = mixer;
+    }
+
+private:
+    QString m_driverName;
+    int m_dev;
+    ProbeResult *m_result;
+};
+
+
 /**
  * Scan for Mixers in the System. This is the method that implicitly fills the
  * list of Mixer's, which is accessible via the static Mixer::mixer() method.
@@ -69,6 +110,9 @@ enum MultiDriverMode { SINGLE, SINGLE_PLUS_MPRIS2, MULTI };
 static void initMixerInternal(MultiDriverMode multiDriverMode, const QStringList &backendList, bool hotplug)
 {  
    bool useBackendFilter = ( ! backendList.isEmpty() );
+#ifdef HAVE_EPOLL
+   FdReactor::startInstance();		// backends may be probed in other threads
+#endif
    bool backendMprisFound = false; // only for SINGLE_PLUS_MPRIS2
    bool regularBackendFound = false; // only for SINGLE_PLUS_MPRIS2
 
@@ -123,7 +167,8 @@ static void initMixerInternal(MultiDriverMode multiDriverMode, const QStringList
       }
       
 
-      bool regularBackend =  driverName != QLatin1String("MPRIS2")  && driverName != QLatin1String("PulseAudio");
+      bool regularBackend =  driverName != QLatin1String("MPRIS2")  && driverName != QLatin1String("PulseAudio")
+                             && driverName != QLatin1String("Replay");
       if (regularBackend && regularBackendFound)
       {
 	  qCDebug(KMIX_LOG) << "Ignored" << driverName << "- regular backend already found";
@@ -137,10 +182,34 @@ static void initMixerInternal(MultiDriverMode multiDriverMode, const QStringList
       // New: We don't try be that clever anymore. We now blindly scan 20 cards, as the clever
       // approach doesn't work for the one or other user (e.g. hotplugging might create holes in the list of soundcards).
       int devNumMax = 19;
+
+      // Opening a device can take a while, so for the regular backends all
+      // of them are probed at once.  PulseAudio and MPRIS2 need the main
+      // thread, and are probed in the loop below as before.  The results
+      // are still added in the order of the device numbers, so that the
+      // mixer IDs are the same as with probing one after the other.
+      std::vector<ProbeResult> probed(devNumMax+1, ProbeResult { nullptr, false });
+      if (regularBackend)
+      {
+          KMixDeviceManager::instance();		// backends use it, create it here
+          QThreadPool pool;
+          for (int dev = 0; dev<=devNumMax; ++dev) pool.start(new ProbeJob(driverName, dev, &probed[dev]));
+          pool.waitForDone();
+      }
+
       for( int dev=0; dev<=devNumMax; dev++ )
       {
-         Mixer *mixer = new Mixer( driverName, dev );
-         bool mixerAccepted = possiblyAddMixer(mixer);
+         bool mixerAccepted;
+         if (regularBackend)
+         {
+             if (probed[dev].valid) mixerAccepted = possiblyAddMixer(probed[dev].mixer);
+             else
+             {
+                 delete probed[dev].mixer;
+                 mixerAccepted = false;
+             }
+         }
+         else mixerAccepted = possiblyAddMixer(new Mixer(driverName, dev));
    
          /* Lets decide if the autoprobing shall end.
           * If the user has configured a backend filter, we will use that as a plain list to obey. It overrides the
@@ -192,7 +261,7 @@ static void initMixerInternal(MultiDriverMode multiDriverMode, const QStringList
       
          if ( mixerAccepted )
          {
-             qCDebug(KMIX_LOG) << "Accepted mixer" << mixer->id() << "for the" << driverName << "driver";
+             qCDebug(KMIX_LOG) << "Accepted mixer" << Mixer::mixers().last()->id() << "for the" << driverName << "driver";
             // append driverName (used drivers)
             if ( !drvInfoAppended )
             {
@@ -285,6 +354,44 @@ void initMixer(bool multiDriverFlag, const QStringList &backendList, bool hotplu
 }
 
 
+/**
+ * Open only the mixers that are in a saved volume snapshot, using the
+ * driver and device number recorded there, instead of probing all
+ * drivers and devices.  This is for restoring volumes quickly.
+ *
+ * @return @c true if all of the mixers in the snapshot were found.  If not,
+ * the mixers that were found are still added, and the caller can fall back
+ * to initMixer() after deinitMixer().
+ */
+bool initMixerFromSnapshot(const VolumeSnapshot &snapshot)
+{
+#ifdef HAVE_EPOLL
+    FdReactor::startInstance();
+#endif
+    bool allFound = true;
+    for (const QString &id : snapshot.mixerIds())
+    {
+        Mixer *mixer = new Mixer(snapshot.driverName(id), snapshot.deviceNumber(id));
+        if (!possiblyAddMixer(mixer))
+        {
+            qCDebug(KMIX_LOG) << "Cannot open mixer" << id;
+            allFound = false;
+            continue;
+        }
+
+        // The device numbering may have changed since the snapshot was saved
+        if (mixer->id()!=id)
+        {
+            qCDebug(KMIX_LOG) << "Mixer" << id << "is now" << mixer->id();
+            allFound = false;
+        }
+    }
+
+    qCDebug(KMIX_LOG) << "Opened" << Mixer::mixers().count() << "of" << snapshot.mixerIds().count() << "saved mixers";
+    return (allFound);
+}
+
+
 /**
  * Opens and adds a mixer to the KMix wide Mixer array, if the given Mixer is valid.
  * Otherwise the Mixer is deleted.
@@ -356,6 +463,10 @@ void deinitMixer()
       delete mixer;
    }
    Mixer::mixers().clear();
+#ifdef HAVE_EPOLL
+   // All of the backends have stopped watching now
+   FdReactor::stopInstance();
+#endif
    // qCDebug(KMIX_LOG) << "OUT MixerToolBox::deinitMixer()";
 }
 
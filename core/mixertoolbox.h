@@ -30,6 +30,7 @@
 #include "kmixcore_export.h"
 
 class Mixer;
+class VolumeSnapshot;
 
 /**
  * This toolbox contains various static methods that are shared throughout KMix.
@@ -41,6 +42,7 @@ class Mixer;
 namespace MixerToolBox
 {
     KMIXCORE_EXPORT void initMixer(bool multiDriverFlag, const QStringList &backendList, bool hotplug);
+    KMIXCORE_EXPORT bool initMixerFromSnapshot(const VolumeSnapshot &snapshot);
 
     KMIXCORE_EXPORT void deinitMixer();
     KMIXCORE_EXPORT bool possiblyAddMixer(Mixer *mixer);
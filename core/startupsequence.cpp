@@ -0,0 +1,143 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "core/startupsequence.h"
+
+#include <QTimer>
+
+#include "kmix_debug.h"
+
+
+StartupSequence::StartupSequence(const QString &name, QObject *parent)
+	: QObject(parent),
+	  m_name(name),
+	  m_started(false)
+{
+	m_elapsed.start();
+}
+
+
+void StartupSequence::addStage(const QString &name, const QStringList &after, const std::function<void()> &run)
+{
+	Q_ASSERT(findStage(name)==nullptr);
+	m_stages.append(Stage { name, after, run, Waiting });
+	if (m_started) scheduleReady();
+}
+
+
+void StartupSequence::start(int delay)
+{
+	qCDebug(KMIX_LOG) << m_name << "startup, first stages in" << delay << "ms";
+	if (delay>0)
+	{
+		QTimer::singleShot(delay, this, [this]() { m_started = true; scheduleReady(); });
+	}
+	else
+	{
+		m_started = true;
+		scheduleReady();
+	}
+}
+
+
+StartupSequence::Stage *StartupSequence::findStage(const QString &name)
+{
+	for (Stage &stage : m_stages)
+	{
+		if (stage.name==name) return (&stage);
+	}
+	return (nullptr);
+}
+
+
+const StartupSequence::Stage *StartupSequence::findStage(const QString &name) const
+{
+	for (const Stage &stage : m_stages)
+	{
+		if (stage.name==name) return (&stage);
+	}
+	return (nullptr);
+}
+
+
+bool StartupSequence::isFinished(const QString &name) const
+{
+	const Stage *stage = findStage(name);
+	return (stage!=nullptr && stage->state==Done);
+}
+
+
+/**
+ * Schedule all of the stages whose inputs are ready.  They are run
+ * from the event loop, not directly, so that one stage finishing does
+ * not run all of the following ones without returning to it.
+ */
+void StartupSequence::scheduleReady()
+{
+	for (Stage &stage : m_stages)
+	{
+		if (stage.state!=Waiting) continue;
+
+		bool ready = true;
+		for (const QString &after : qAsConst(stage.after))
+		{
+			// A stage that was never added is not waited for
+			const Stage *needed = findStage(after);
+			if (needed!=nullptr && needed->state!=Done)
+			{
+				ready = false;
+				break;
+			}
+		}
+		if (!ready) continue;
+
+		stage.state = Scheduled;
+		const QString name = stage.name;
+		QTimer::singleShot(0, this, [this, name]() { runStage(name); });
+	}
+}
+
+
+void StartupSequence::runStage(const QString &name)
+{
+	Stage *stage = findStage(name);
+	Q_ASSERT(stage!=nullptr && stage->state==Scheduled);
+
+	stage->state = Running;
+	const qint64 startedAt = m_elapsed.elapsed();
+	const std::function<void()> run = stage->run;
+	run();					// may add more stages
+
+	stage = findStage(name);		// the list may have grown
+	stage->state = Done;
+	const qint64 now = m_elapsed.elapsed();
+	qCDebug(KMIX_LOG) << m_name << "stage" << name << "took" << (now-startedAt)
+			  << "ms, started at" << startedAt << "ms";
+
+	bool allDone = true;
+	for (const Stage &other : qAsConst(m_stages))
+	{
+		if (other.state!=Done)
+		{
+			allDone = false;
+			break;
+		}
+	}
+	if (allDone) qCDebug(KMIX_LOG) << m_name << "startup finished after" << now << "ms";
+	else scheduleReady();
+}
@@ -0,0 +1,84 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef STARTUPSEQUENCE_H
+#define STARTUPSEQUENCE_H
+
+#include <functional>
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "kmixcore_export.h"
+
+/**
+ * The stages of starting up an application or the daemon.  Each stage
+ * runs from the event loop after all of the stages that it needs, so
+ * that events (e.g. painting or D-Bus calls) are handled in between.
+ * A stage has finished when it returns.  The time that each stage takes
+ * is logged.
+ */
+class KMIXCORE_EXPORT StartupSequence : public QObject
+{
+	Q_OBJECT
+
+	public:
+		explicit StartupSequence(const QString &name, QObject *parent = nullptr);
+
+		/**
+		 * Add a stage.
+		 *
+		 * @param after the stages that must have finished first
+		 */
+		void addStage(const QString &name, const QStringList &after, const std::function<void()> &run);
+
+		/**
+		 * Start running the stages.
+		 *
+		 * @param delay the time in milliseconds before the first stages run
+		 */
+		void start(int delay = 0);
+
+		bool isFinished(const QString &name) const;
+
+	private:
+		enum StageState { Waiting, Scheduled, Running, Done };
+
+		struct Stage
+		{
+			QString name;
+			QStringList after;
+			std::function<void()> run;
+			StageState state;
+		};
+
+		void scheduleReady();
+		void runStage(const QString &name);
+		Stage *findStage(const QString &name);
+		const Stage *findStage(const QString &name) const;
+
+		QString m_name;
+		QList<Stage> m_stages;
+		QElapsedTimer m_elapsed;
+		bool m_started;
+};
+
+#endif /* STARTUPSEQUENCE_H */
@@ -0,0 +1,326 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "core/topologycache.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+
+#include "backends/mixer_backend.h"
+#include "core/mixer.h"
+#include "core/volume.h"
+#include "kmix_debug.h"
+
+static const quint32 cacheMagic = 0x4b4d5854;		// "KMXT"
+static const quint32 cacheVersion = 1;
+
+
+/**
+ * The backend of a placeholder mixer.  Its controls are created from
+ * the cache, and it does not access any hardware.  It is never open,
+ * so that its volumes are not saved.
+ */
+class Mixer_Cached : public Mixer_Backend
+{
+public:
+	Mixer_Cached(Mixer *mixer, int device) : Mixer_Backend(mixer, device)	{}
+	~Mixer_Cached() override				{ closeCommon(); }
+
+	void setIdentity(const QString &driver, const QString &driverVersion, const QString &name,
+			 int cardInstance, const QString &udi)
+	{
+		m_driver = driver;
+		m_driverVersion = driverVersion;
+		registerCard(name);
+		_cardInstance = cardInstance;
+		_udi = udi;
+	}
+
+	void addControl(shared_ptr<MixDevice> md)		{ m_mixDevices.append(md); }
+	const QSet<QString> &changedControls() const		{ return (m_changed); }
+
+protected:
+	int open() override					{ return (0); }
+	int close() override					{ return (0); }
+	QString getDriverName() override			{ return (m_driver); }
+	QString driverVersion() const override			{ return (m_driverVersion); }
+	bool needsPolling() override				{ return (false); }
+
+	int readVolumeFromHW(const QString &, shared_ptr<MixDevice>) override
+	{
+		return (Mixer::OK_UNCHANGED);
+	}
+
+	int writeVolumeToHW(const QString &id, shared_ptr<MixDevice>) override
+	{
+		m_changed.insert(id);
+		return (Mixer::OK);
+	}
+
+	void setEnumIdHW(const QString &id, unsigned int) override
+	{
+		m_changed.insert(id);
+	}
+
+	unsigned int enumIdHW(const QString &id) override
+	{
+		shared_ptr<MixDevice> md = m_mixDevices.get(id);
+		return (md ? md->enumId() : 0);
+	}
+
+private:
+	QString m_driver;
+	QString m_driverVersion;
+	QSet<QString> m_changed;
+};
+
+
+static void writeVolume(QDataStream &stream, Volume &vol)
+{
+	const QMap<Volume::ChannelID, VolumeChannel> &channels = vol.getVolumes();
+	stream << static_cast<qint64>(vol.maxVolume()) << static_cast<qint64>(vol.minVolume())
+	       << vol.hasSwitch() << static_cast<qint32>(vol.switchType())
+	       << static_cast<quint32>(channels.count());
+	for (const VolumeChannel &vc : channels)
+	{
+		stream << static_cast<qint32>(vc.chid) << static_cast<qint64>(vc.volume);
+	}
+}
+
+static void readVolume(QDataStream &stream, MixDevice *md, bool capture)
+{
+	qint64 maxVolume, minVolume;
+	bool hasSwitch;
+	qint32 switchType;
+	quint32 count;
+	stream >> maxVolume >> minVolume >> hasSwitch >> switchType >> count;
+
+	Volume vol(maxVolume, minVolume, hasSwitch, capture);
+	vol.setSwitchType(static_cast<Volume::SwitchType>(switchType));
+	for (quint32 i = 0; i<count && stream.status()==QDataStream::Ok; ++i)
+	{
+		qint32 chid;
+		qint64 value;
+		stream >> chid >> value;
+		if (chid<Volume::CHIDMIN || chid>Volume::CHIDMAX) continue;
+		vol.addVolumeChannel(VolumeChannel(static_cast<Volume::ChannelID>(chid)));
+		vol.setVolume(static_cast<Volume::ChannelID>(chid), value);
+	}
+
+	// As a backend would, only add a volume that has something to control
+	if (count==0 && !hasSwitch) return;
+	if (capture) md->addCaptureVolume(vol);
+	else md->addPlaybackVolume(vol);
+}
+
+
+void TopologyCache::writeControl(QDataStream &stream, const shared_ptr<MixDevice> &md)
+{
+	stream << md->id() << md->readableName() << md->iconName() << md->enumValues()
+	       << static_cast<qint32>(md->enumId()) << md->isMuted() << md->isRecSource();
+	writeVolume(stream, md->playbackVolume());
+	writeVolume(stream, md->captureVolume());
+}
+
+
+shared_ptr<MixDevice> TopologyCache::readControl(QDataStream &stream, Mixer *mixer)
+{
+	QString controlId, controlName, iconName;
+	QStringList enumValues;
+	qint32 enumId;
+	bool muted, recSource;
+	stream >> controlId >> controlName >> iconName >> enumValues >> enumId >> muted >> recSource;
+
+	MixDevice *md = new MixDevice(mixer, controlId, controlName, iconName);
+	readVolume(stream, md, false);
+	readVolume(stream, md, true);
+	if (!enumValues.isEmpty())
+	{
+		QList<QString *> enumList;
+		for (const QString &value : qAsConst(enumValues)) enumList.append(new QString(value));
+		md->addEnums(enumList);
+		qDeleteAll(enumList);
+		md->setEnumId(enumId);
+	}
+	if (md->hasMuteSwitch()) md->setMuted(muted);
+	if (md->captureVolume().hasSwitch()) md->setRecSource(recSource);
+	return (md->addToPool());
+}
+
+
+QString TopologyCache::fileName()
+{
+	return (QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)+"/kmix/topology");
+}
+
+
+bool TopologyCache::save()
+{
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_6);
+
+	QList<Mixer *> cached;
+	for (Mixer *mixer : qAsConst(Mixer::mixers()))
+	{
+		if (mixer->isDynamic()) continue;
+		// Neither the placeholders nor the mixers of a replayed recording
+		if (!mixer->isOpen()) continue;
+		cached.append(mixer);
+	}
+
+	stream << cacheMagic << cacheVersion << static_cast<quint32>(cached.count());
+	for (Mixer *mixer : qAsConst(cached))
+	{
+		QList<shared_ptr<MixDevice> > controls;
+		for (const shared_ptr<MixDevice> &md : qAsConst(mixer->getMixSet()))
+		{
+			if (!md->isArtificial()) controls.append(md);
+		}
+
+		const shared_ptr<MixDevice> master = mixer->getLocalMasterMD();
+		stream << mixer->id() << mixer->getDriverName() << mixer->driverVersion()
+		       << mixer->udi() << mixer->getBaseName()
+		       << static_cast<qint32>(mixer->deviceNumber()) << static_cast<qint32>(mixer->getCardInstance())
+		       << (master ? master->id() : QString())
+		       << static_cast<quint32>(controls.count());
+
+		for (const shared_ptr<MixDevice> &md : qAsConst(controls)) writeControl(stream, md);
+	}
+
+	const QString name = fileName();
+	QDir().mkpath(name.section('/', 0, -2));
+	QSaveFile file(name);
+	if (!file.open(QIODevice::WriteOnly) || file.write(data)!=data.size() || !file.commit())
+	{
+		qCWarning(KMIX_LOG) << "Cannot save topology cache" << name << file.errorString();
+		return (false);
+	}
+
+	qCDebug(KMIX_LOG) << "Saved topology of" << cached.count() << "mixers";
+	return (true);
+}
+
+
+QList<Mixer *> TopologyCache::createMixers()
+{
+	QList<Mixer *> mixers;
+
+	QFile file(fileName());
+	if (!file.open(QIODevice::ReadOnly)) return (mixers);
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_6);
+
+	quint32 magic, version, mixerCount;
+	stream >> magic >> version >> mixerCount;
+	if (stream.status()!=QDataStream::Ok || magic!=cacheMagic || version!=cacheVersion)
+	{
+		qCDebug(KMIX_LOG) << "Ignoring topology cache" << file.fileName() << "with a different version";
+		return (mixers);
+	}
+
+	for (quint32 m = 0; m<mixerCount && stream.status()==QDataStream::Ok; ++m)
+	{
+		QString id, driver, driverVersion, udi, name, masterId;
+		qint32 device, cardInstance;
+		quint32 controlCount;
+		stream >> id >> driver >> driverVersion >> udi >> name >> device >> cardInstance
+		       >> masterId >> controlCount;
+
+		// A mixer with no backend, which is then given the placeholder backend
+		Mixer *mixer = new Mixer(QString(), device);
+		Mixer_Cached *backend = new Mixer_Cached(mixer, device);
+		backend->setIdentity(driver, driverVersion, name, cardInstance, udi);
+		mixer->_mixerBackend = backend;
+		mixer->_id = id;
+		mixers.append(mixer);
+
+		for (quint32 c = 0; c<controlCount && stream.status()==QDataStream::Ok; ++c)
+		{
+			backend->addControl(readControl(stream, mixer));
+		}
+
+		mixer->setLocalMasterMD(masterId);
+	}
+
+	if (stream.status()!=QDataStream::Ok)
+	{
+		qCWarning(KMIX_LOG) << "Topology cache" << file.fileName() << "is corrupt, ignoring";
+		qDeleteAll(mixers);
+		mixers.clear();
+		return (mixers);
+	}
+
+	qCDebug(KMIX_LOG) << "Created" << mixers.count() << "mixers from the topology cache";
+	return (mixers);
+}
+
+
+void TopologyCache::reconcile(const QList<Mixer *> &placeholders)
+{
+	for (Mixer *placeholder : placeholders)
+	{
+		Mixer_Cached *backend = dynamic_cast<Mixer_Cached *>(placeholder->_mixerBackend);
+		if (backend==nullptr) continue;
+
+		Mixer *mixer = Mixer::findMixer(placeholder->id());
+		if (mixer==nullptr || mixer->udi()!=placeholder->udi())
+		{
+			qCDebug(KMIX_LOG) << "Cached mixer" << placeholder->id() << "is not present";
+			continue;
+		}
+
+		if (mixer->driverVersion()!=placeholder->driverVersion() ||
+		    mixer->getMixSet().count()!=placeholder->getMixSet().count())
+		{
+			qCDebug(KMIX_LOG) << "Controls of" << mixer->id() << "may have changed since they were cached";
+		}
+
+		// Carry over what the user changed before the real mixer was ready
+		QList<shared_ptr<MixDevice> > changed;
+		for (const QString &controlId : backend->changedControls())
+		{
+			const shared_ptr<MixDevice> cachedMd = placeholder->getMixdeviceById(controlId);
+			const shared_ptr<MixDevice> md = mixer->getMixdeviceById(controlId);
+			if (!cachedMd || !md) continue;
+
+			for (const VolumeChannel &vc : cachedMd->playbackVolume().getVolumes())
+			{
+				md->playbackVolume().setVolume(vc.chid, vc.volume);
+			}
+			for (const VolumeChannel &vc : cachedMd->captureVolume().getVolumes())
+			{
+				md->captureVolume().setVolume(vc.chid, vc.volume);
+			}
+			if (md->hasMuteSwitch()) md->setMuted(cachedMd->isMuted());
+			if (md->captureVolume().hasSwitch()) md->setRecSource(cachedMd->isRecSource());
+			if (md->isEnum()) md->setEnumId(cachedMd->enumId());
+			changed.append(md);
+		}
+
+		if (!changed.isEmpty())
+		{
+			qCDebug(KMIX_LOG) << "Applying" << changed.count() << "changed controls to" << mixer->id();
+			mixer->commitVolumeChanges(changed);
+		}
+	}
+}
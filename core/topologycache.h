@@ -0,0 +1,87 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef TOPOLOGYCACHE_H
+#define TOPOLOGYCACHE_H
+
+#include <QList>
+#include <QString>
+
+#include "core/mixdevice.h"
+#include "kmixcore_export.h"
+
+class Mixer;
+class QDataStream;
+
+/**
+ * A cache of the controls of each mixer as they were last enumerated:
+ * their IDs, names, icons, channels, ranges, enum items and their last
+ * values.  It is saved together with the card identity (mixer ID and
+ * UDI) and the driver version.
+ *
+ * At startup, the cache can be used to create placeholder mixers that
+ * show the controls straight away, without opening any hardware.  Once
+ * the real mixers have been opened, reconcile() carries over anything
+ * that the user changed in the meantime and the placeholders can be
+ * replaced by the real mixers.
+ *
+ * Only mixers that are not dynamic are cached, as the controls of a
+ * dynamic mixer (e.g. PulseAudio streams) come and go.
+ */
+class KMIXCORE_EXPORT TopologyCache
+{
+	public:
+		/**
+		 * Create placeholder mixers for all of the mixers in the
+		 * cache.  They are not added to Mixer::mixers(), and writes
+		 * to them are only recorded, not sent to any hardware.
+		 *
+		 * @return the placeholders, or an empty list if there is
+		 * no usable cache
+		 */
+		static QList<Mixer *> createMixers();
+
+		/**
+		 * Apply the controls that were changed on the placeholders
+		 * to the real mixers with the same identity, which must by
+		 * now be in Mixer::mixers().  The placeholders can then be
+		 * deleted.
+		 */
+		static void reconcile(const QList<Mixer *> &placeholders);
+
+		/**
+		 * Save the controls of all of the real mixers in Mixer::mixers().
+		 */
+		static bool save();
+
+		static QString fileName();
+
+		/**
+		 * Write a control, with its current values, in the format
+		 * of the cache.
+		 */
+		static void writeControl(QDataStream &stream, const shared_ptr<MixDevice> &md);
+
+		/**
+		 * Create a control of @p mixer as written by writeControl().
+		 * It is not added to the mixer.
+		 */
+		static shared_ptr<MixDevice> readControl(QDataStream &stream, Mixer *mixer);
+};
+
+#endif /* TOPOLOGYCACHE_H */
@@ -0,0 +1,304 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "core/volumesnapshot.h"
+
+#include <string.h>
+
+#include <QDir>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtEndian>
+
+#include "core/mixer.h"
+#include "core/mixset.h"
+#include "core/volume.h"
+#include "kmix_debug.h"
+
+static const char snapshotMagic[4] = { 'K', 'M', 'X', 'V' };
+static const quint32 snapshotVersion = 2;
+
+enum SnapshotFlags
+{
+	SnapshotMuted = 0x01,
+	SnapshotRecSource = 0x02,
+	SnapshotEnum = 0x04
+};
+
+
+/**
+ * Bounds checked reading from the mapped file.
+ */
+class SnapshotReader
+{
+public:
+	SnapshotReader(const uchar *data, qint64 size)
+		: m_pos(data), m_end(data+size), m_ok(true)	{}
+
+	bool ok() const					{ return (m_ok); }
+	const uchar *pos() const			{ return (m_pos); }
+
+	bool skip(qint64 len)
+	{
+		len = (len+3) & ~3;				// keep alignment
+		if (!m_ok || len>(m_end-m_pos)) return (m_ok = false);
+		m_pos += len;
+		return (true);
+	}
+
+	quint32 u32()
+	{
+		if (!m_ok || (m_end-m_pos)<4) { m_ok = false; return (0); }
+		const quint32 v = qFromLittleEndian<quint32>(m_pos);
+		m_pos += 4;
+		return (v);
+	}
+
+	qint32 i32()					{ return (static_cast<qint32>(u32())); }
+
+	QString string()
+	{
+		const quint32 len = u32();
+		const uchar *p = m_pos;
+		if (!skip(len)) return (QString());
+		return (QString::fromUtf8(reinterpret_cast<const char *>(p), len));
+	}
+
+private:
+	const uchar *m_pos;
+	const uchar *m_end;
+	bool m_ok;
+};
+
+
+static void appendU32(QByteArray &buf, quint32 v)
+{
+	uchar b[4];
+	qToLittleEndian<quint32>(v, b);
+	buf.append(reinterpret_cast<const char *>(b), 4);
+}
+
+static void appendString(QByteArray &buf, const QString &s)
+{
+	const QByteArray utf8 = s.toUtf8();
+	appendU32(buf, utf8.size());
+	buf.append(utf8);
+	while (buf.size() & 3) buf.append('\0');
+}
+
+
+VolumeSnapshot::VolumeSnapshot(const QString &configName)
+	: m_fileName(fileName(configName)),
+	  m_data(nullptr),
+	  m_size(0)
+{
+}
+
+VolumeSnapshot::~VolumeSnapshot()
+{
+	if (m_data!=nullptr) m_file.unmap(const_cast<uchar *>(m_data));
+}
+
+
+QString VolumeSnapshot::fileName(const QString &configName)
+{
+	return (QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation)+
+		"/kmix/"+configName+".volumes");
+}
+
+
+bool VolumeSnapshot::open()
+{
+	m_file.setFileName(m_fileName);
+	if (!m_file.open(QIODevice::ReadOnly)) return (false);
+
+	m_size = m_file.size();
+	m_data = m_file.map(0, m_size);
+	if (m_data==nullptr) return (false);
+
+	SnapshotReader reader(m_data, m_size);
+	if (m_size<4 || memcmp(m_data, snapshotMagic, 4)!=0) return (false);
+	reader.skip(4);
+	if (reader.u32()!=snapshotVersion)
+	{
+		qCDebug(KMIX_LOG) << "Ignoring snapshot" << m_fileName << "with a different version";
+		return (false);
+	}
+
+	const quint32 mixerCount = reader.u32();
+	for (quint32 i = 0; i<mixerCount && reader.ok(); ++i)
+	{
+		MixerEntry entry;
+		entry.block = reader.pos();
+		const QString id = reader.string();
+		entry.driver = reader.string();
+		entry.device = reader.i32();
+		entry.count = reader.u32();
+		const quint32 length = reader.u32();
+		entry.controls = reader.pos();
+		if (!reader.skip(length)) break;
+		entry.blockLength = reader.pos()-entry.block;
+		m_mixers.insert(id, entry);
+	}
+
+	if (!reader.ok())
+	{
+		qCWarning(KMIX_LOG) << "Snapshot" << m_fileName << "is corrupt, ignoring";
+		m_mixers.clear();
+		return (false);
+	}
+	return (true);
+}
+
+
+bool VolumeSnapshot::restore(const QString &mixerId, MixSet &mixSet) const
+{
+	QHash<QString,MixerEntry>::const_iterator it = m_mixers.constFind(mixerId);
+	if (it==m_mixers.constEnd()) return (false);
+
+	const MixerEntry &entry = it.value();
+	SnapshotReader reader(entry.controls, (entry.block+entry.blockLength)-entry.controls);
+	for (quint32 i = 0; i<entry.count && reader.ok(); ++i)
+	{
+		const QString id = reader.string();
+		const quint32 header = reader.u32();
+		const qint32 enumId = reader.i32();
+		const int flags = header & 0xff;
+		const int playbackCount = (header >> 8) & 0xff;
+		const int captureCount = (header >> 16) & 0xff;
+
+		shared_ptr<MixDevice> md = mixSet.get(id);
+		if (!md || md->isArtificial())
+		{
+			reader.skip(8*(playbackCount+captureCount));
+			continue;
+		}
+
+		for (int c = 0; c<playbackCount+captureCount; ++c)
+		{
+			const Volume::ChannelID chid = static_cast<Volume::ChannelID>(reader.i32());
+			const qint32 vol = reader.i32();
+			if (chid<Volume::CHIDMIN || chid>Volume::CHIDMAX) continue;
+			if (c<playbackCount) md->playbackVolume().setVolume(chid, vol);
+			else md->captureVolume().setVolume(chid, vol);
+		}
+
+		md->setMuted(flags & SnapshotMuted);
+		md->setRecSource(flags & SnapshotRecSource);
+		if (flags & SnapshotEnum) md->setEnumId(enumId);
+	}
+
+	return (reader.ok());
+}
+
+
+/**
+ * Encode a mixer and its controls, as MixDevice::write() would save them.
+ */
+static void appendMixer(QByteArray &mixers, const Mixer *mixer)
+{
+	QByteArray controls;
+	quint32 count = 0;
+	for (const shared_ptr<MixDevice> md : qAsConst(mixer->getMixSet()))
+	{
+		if (md->isArtificial()) continue;
+
+		const QMap<Volume::ChannelID, VolumeChannel> playback = md->playbackVolume().getVolumes();
+		const QMap<Volume::ChannelID, VolumeChannel> capture = md->captureVolume().getVolumes();
+
+		quint32 flags = 0;
+		if (md->isMuted()) flags |= SnapshotMuted;
+		if (md->isRecSource()) flags |= SnapshotRecSource;
+		if (md->isEnum()) flags |= SnapshotEnum;
+
+		appendString(controls, md->id());
+		appendU32(controls, flags | (playback.count() << 8) | (capture.count() << 16));
+		appendU32(controls, md->isEnum() ? md->enumId() : 0);
+		for (const VolumeChannel &vc : playback)
+		{
+			appendU32(controls, vc.chid);
+			appendU32(controls, static_cast<qint32>(vc.volume));
+		}
+		for (const VolumeChannel &vc : capture)
+		{
+			appendU32(controls, vc.chid);
+			appendU32(controls, static_cast<qint32>(vc.volume));
+		}
+		++count;
+	}
+
+	appendString(mixers, mixer->id());
+	appendString(mixers, mixer->getDriverName());
+	appendU32(mixers, mixer->deviceNumber());
+	appendU32(mixers, count);
+	appendU32(mixers, controls.size());
+	mixers.append(controls);
+}
+
+
+bool VolumeSnapshot::save(const QString &configName, const QList<const Mixer *> &mixers)
+{
+	const QString name = fileName(configName);
+	QDir().mkpath(name.section('/', 0, -2));
+
+	// KMix and kmixctrl may both save, each keeping the other's mixers
+	QLockFile lock(name+".lock");
+	if (!lock.tryLock(5000))
+	{
+		qCWarning(KMIX_LOG) << "Cannot lock snapshot" << name << lock.error();
+		return (false);
+	}
+
+	QByteArray mixerData;
+	quint32 mixerCount = 0;
+	QStringList ids;
+	for (const Mixer *mixer : mixers) ids.append(mixer->id());
+
+	// Keep the other mixers from any existing snapshot as they are
+	VolumeSnapshot existing(configName);
+	if (existing.open())
+	{
+		for (QHash<QString,MixerEntry>::const_iterator it = existing.m_mixers.constBegin();
+		     it!=existing.m_mixers.constEnd(); ++it)
+		{
+			if (ids.contains(it.key())) continue;
+			mixerData.append(reinterpret_cast<const char *>(it.value().block), it.value().blockLength);
+			++mixerCount;
+		}
+	}
+
+	for (const Mixer *mixer : mixers)
+	{
+		appendMixer(mixerData, mixer);
+		++mixerCount;
+	}
+
+	QByteArray data(snapshotMagic, 4);
+	appendU32(data, snapshotVersion);
+	appendU32(data, mixerCount);
+	data.append(mixerData);
+
+	QSaveFile file(name);
+	if (!file.open(QIODevice::WriteOnly) || file.write(data)!=data.size() || !file.commit())
+	{
+		qCWarning(KMIX_LOG) << "Cannot save snapshot" << name << file.errorString();
+		return (false);
+	}
+	return (true);
+}
@@ -0,0 +1,113 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef VOLUMESNAPSHOT_H
+#define VOLUMESNAPSHOT_H
+
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "kmixcore_export.h"
+
+class Mixer;
+class MixSet;
+
+/**
+ * A binary snapshot of saved volumes, kept alongside the KConfig file
+ * that Mixer::volumeSave() writes.  It is much quicker to restore from,
+ * as the file is mapped into memory and only needs to be indexed, not
+ * parsed as text.  If there is no snapshot, or it does not contain a
+ * mixer, the KConfig file is used as before.
+ *
+ * All values are little endian and every item is aligned to 4 bytes.
+ *
+ *   header:	"KMXV", uint32 version, uint32 mixer count
+ *   mixer:	string ID, string driver, uint32 device number,
+ *		uint32 control count, uint32 length of controls
+ *   control:	string ID, uint8 flags, uint8 playback channels,
+ *		uint8 capture channels, uint8 reserved, int32 enum ID,
+ *		then { int32 channel ID, int32 volume } for each channel
+ *   string:	uint32 length in bytes, UTF-8 data, padding
+ */
+class KMIXCORE_EXPORT VolumeSnapshot
+{
+	public:
+		/**
+		 * @param configName the name of the KConfig file that the
+		 * volumes are also saved to, e.g. "kmixctrlrc"
+		 */
+		explicit VolumeSnapshot(const QString &configName);
+		~VolumeSnapshot();
+
+		/**
+		 * Map and index the snapshot file.
+		 *
+		 * @return @c true if there is a valid snapshot
+		 */
+		bool open();
+
+		bool hasMixer(const QString &mixerId) const	{ return (m_mixers.contains(mixerId)); }
+		QStringList mixerIds() const			{ return (m_mixers.keys()); }
+
+		/**
+		 * The driver name and device number that the mixer was
+		 * opened with, so that it can be opened again directly.
+		 */
+		QString driverName(const QString &mixerId) const	{ return (m_mixers.value(mixerId).driver); }
+		int deviceNumber(const QString &mixerId) const		{ return (m_mixers.value(mixerId).device); }
+
+		/**
+		 * Set the controls of a mixer to the saved values.
+		 * Nothing is written to the hardware.
+		 *
+		 * @return @c true if the mixer was in the snapshot
+		 */
+		bool restore(const QString &mixerId, MixSet &mixSet) const;
+
+		/**
+		 * Save the current values of the controls of some mixers,
+		 * keeping any other mixers already in the snapshot.  The
+		 * file is written once, and locked against other processes
+		 * saving at the same time.
+		 */
+		static bool save(const QString &configName, const QList<const Mixer *> &mixers);
+
+		static QString fileName(const QString &configName);
+
+	private:
+		struct MixerEntry
+		{
+			const uchar *block;		// the whole mixer entry
+			quint32 blockLength;
+			const uchar *controls;
+			quint32 count;
+			QString driver;
+			int device;
+		};
+
+		QString m_fileName;
+		QFile m_file;
+		const uchar *m_data;
+		qint64 m_size;
+		QHash<QString,MixerEntry> m_mixers;
+};
+
+#endif /* VOLUMESNAPSHOT_H */
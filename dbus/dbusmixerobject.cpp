@@ -0,0 +1,451 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * Copyright 1996-2004 Christian Esken <esken@kde.org>
+ * Copyright 2011 Igor Poboiko <igor.poboiko@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "dbusmixerobject.h"
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusVariant>
+
+#include "core/mixer.h"
+#include "core/volume.h"
+#include "dbus/dbusmixerwrapper.h"
+#include "kmix_debug.h"
+#include "mixeradaptor.h"
+
+static const QString mixerInterface("org.kde.KMix.Mixer");
+static const QString controlInterface("org.kde.KMix.Control");
+static const QString propertiesInterface("org.freedesktop.DBus.Properties");
+static const QString introspectableInterface("org.freedesktop.DBus.Introspectable");
+
+// Introspection data for a control.  This must be kept in
+// step with org.kde.kmix.control.xml, which is the published
+// description of the interface.
+static const char controlIntrospection[] =
+	"  <interface name=\"org.kde.KMix.Control\">\n"
+	"    <property access=\"read\" name=\"id\" type=\"s\"/>\n"
+	"    <property access=\"read\" name=\"readableName\" type=\"s\"/>\n"
+	"    <property access=\"read\" name=\"iconName\" type=\"s\"/>\n"
+	"    <property access=\"readwrite\" name=\"mute\" type=\"b\"/>\n"
+	"    <property access=\"read\" name=\"canMute\" type=\"b\"/>\n"
+	"    <property access=\"readwrite\" name=\"recordSource\" type=\"b\"/>\n"
+	"    <property access=\"read\" name=\"hasCaptureSwitch\" type=\"b\"/>\n"
+	"    <property access=\"readwrite\" name=\"volume\" type=\"i\"/>\n"
+	"    <property access=\"readwrite\" name=\"absoluteVolume\" type=\"i\"/>\n"
+	"    <property access=\"read\" name=\"absoluteVolumeMin\" type=\"i\"/>\n"
+	"    <property access=\"read\" name=\"absoluteVolumeMax\" type=\"i\"/>\n"
+	"    <method name=\"increaseVolume\"/>\n"
+	"    <method name=\"decreaseVolume\"/>\n"
+	"    <method name=\"toggleMute\"/>\n"
+	"  </interface>\n";
+
+
+static void sendReply(const QDBusMessage &message, const QDBusConnection &connection, const QVariant &value = QVariant())
+{
+	if (!message.isReplyRequired()) return;
+
+	QDBusMessage reply = message.createReply();
+	if (value.isValid()) reply << value;
+	connection.send(reply);
+}
+
+static void sendError(const QDBusMessage &message, const QDBusConnection &connection,
+		      QDBusError::ErrorType type, const QString &text)
+{
+	connection.send(message.createErrorReply(type, text));
+}
+
+
+DBusMixerObject::DBusMixerObject(Mixer *mixer, const QString &path, DBusMixerWrapper *mixerWrapper)
+	: QDBusVirtualObject(mixerWrapper),
+	  m_mixer(mixer),
+	  m_path(path),
+	  m_mixerWrapper(mixerWrapper),
+	  m_controlsValid(false)
+{
+	QDBusConnection::sessionBus().registerVirtualObject(m_path, this, QDBusConnection::SubPath);
+}
+
+DBusMixerObject::~DBusMixerObject()
+{
+	QDBusConnection::sessionBus().unregisterObject(m_path);
+}
+
+
+void DBusMixerObject::updateControls() const
+{
+	m_controls.clear();
+	const int prefixLength = m_path.length()+1;
+	for (const shared_ptr<MixDevice> md : qAsConst(m_mixer->getMixSet()))
+	{
+		m_controls.insert(md->dbusPath().mid(prefixLength), md->id());
+	}
+	m_controlsValid = true;
+}
+
+shared_ptr<MixDevice> DBusMixerObject::findControl(const QString &path) const
+{
+	if (!path.startsWith(m_path+'/')) return (shared_ptr<MixDevice>());
+
+	if (!m_controlsValid) updateControls();
+	const QString id = m_controls.value(path.mid(m_path.length()+1));
+	if (id.isEmpty()) return (shared_ptr<MixDevice>());
+	return (m_mixer->getMixSet().get(id));
+}
+
+
+QString DBusMixerObject::introspect(const QString &path) const
+{
+	if (path==m_path)
+	{
+		// The adaptor is only generated for its introspection
+		// data, taken from the org.kde.kmix.mixer.xml interface
+		QString xml;
+		const QMetaObject &mo = MixerAdaptor::staticMetaObject;
+		const int idx = mo.indexOfClassInfo("D-Bus Introspection");
+		if (idx>=0) xml = QString::fromUtf8(mo.classInfo(idx).value());
+
+		if (!m_controlsValid) updateControls();
+		for (QHash<QString,QString>::const_iterator it = m_controls.constBegin(); it!=m_controls.constEnd(); ++it)
+		{
+			xml += QString("  <node name=\"%1\"/>\n").arg(it.key());
+		}
+		return (xml);
+	}
+
+	if (findControl(path)) return (QString::fromLatin1(controlIntrospection));
+	return (QString());
+}
+
+
+bool DBusMixerObject::handleMessage(const QDBusMessage &message, const QDBusConnection &connection)
+{
+	// Introspection is done by Qt, calling introspect() above
+	if (message.interface()==introspectableInterface) return (false);
+
+	const QString path = message.path();
+	if (path==m_path) return (handleMixerMessage(message, connection));
+
+	shared_ptr<MixDevice> md = findControl(path);
+	if (!md)
+	{
+		sendError(message, connection, QDBusError::UnknownObject, QString("No such control %1").arg(path));
+		return (true);
+	}
+
+	return (handleControlMessage(md, message, connection));
+}
+
+
+/**
+ * The current values of all of the properties of
+ * the org.kde.KMix.Mixer interface, keyed by name.
+ */
+QVariantMap DBusMixerObject::mixerState() const
+{
+	QVariantMap state;
+	state.insert("driverName", m_mixerWrapper->driverName());
+	state.insert("masterControl", m_mixerWrapper->masterControl());
+	state.insert("opened", m_mixerWrapper->isOpened());
+	state.insert("readableName", m_mixerWrapper->readableName());
+	state.insert("id", m_mixerWrapper->id());
+	state.insert("udi", m_mixerWrapper->udi());
+	state.insert("balance", m_mixerWrapper->balance());
+	state.insert("controls", m_mixerWrapper->controls());
+	state.insert("signalsSent", m_mixerWrapper->signalsSent());
+	state.insert("signalsSuppressed", m_mixerWrapper->signalsSuppressed());
+	return (state);
+}
+
+
+bool DBusMixerObject::handleMixerMessage(const QDBusMessage &message, const QDBusConnection &connection)
+{
+	const QString interface = message.interface();
+	const QString member = message.member();
+	const QString signature = message.signature();
+	const QList<QVariant> args = message.arguments();
+
+	if (interface==propertiesInterface)
+	{
+		if (args.isEmpty() || (!args.at(0).toString().isEmpty() && args.at(0).toString()!=mixerInterface))
+		{
+			sendError(message, connection, QDBusError::UnknownInterface, QString("No such interface %1").arg(args.value(0).toString()));
+			return (true);
+		}
+
+		const QVariantMap state = mixerState();
+		if (member=="GetAll" && signature=="s")
+		{
+			sendReply(message, connection, state);
+			return (true);
+		}
+
+		const QString name = args.value(1).toString();
+		if (!state.contains(name))
+		{
+			sendError(message, connection, QDBusError::UnknownProperty, QString("No such property %1").arg(name));
+			return (true);
+		}
+
+		if (member=="Get" && signature=="ss")
+		{
+			sendReply(message, connection, QVariant::fromValue(QDBusVariant(state.value(name))));
+			return (true);
+		}
+
+		if (member=="Set" && signature=="ssv")
+		{
+			const QVariant value = qvariant_cast<QDBusVariant>(args.at(2)).variant();
+			if (name!="balance")
+			{
+				sendError(message, connection, QDBusError::PropertyReadOnly, QString("Property %1 is read only").arg(name));
+			}
+			else if (value.userType()!=QMetaType::Int)
+			{
+				sendError(message, connection, QDBusError::InvalidArgs, QString("Property %1 must be an int32").arg(name));
+			}
+			else
+			{
+				m_mixerWrapper->setBalance(value.toInt());
+				sendReply(message, connection);
+			}
+			return (true);
+		}
+	}
+	else if (interface.isEmpty() || interface==mixerInterface)
+	{
+		if (member=="controlStates" && signature.isEmpty())
+		{
+			sendReply(message, connection, QVariant::fromValue(m_mixerWrapper->controlStates()));
+			return (true);
+		}
+
+		if (member=="setControlStates" && signature=="a{sa{sv}}")
+		{
+			const ControlStateMap states = qdbus_cast<ControlStateMap>(args.at(0));
+			sendReply(message, connection, QVariant::fromValue(m_mixerWrapper->setControlStates(states)));
+			return (true);
+		}
+	}
+
+	sendError(message, connection, QDBusError::UnknownMethod, QString("No such method %1.%2 with signature %3").arg(interface, member, signature));
+	return (true);
+}
+
+
+bool DBusMixerObject::handleControlMessage(shared_ptr<MixDevice> md, const QDBusMessage &message, const QDBusConnection &connection)
+{
+	const QString interface = message.interface();
+	const QString member = message.member();
+	const QList<QVariant> args = message.arguments();
+
+	if (interface==propertiesInterface)
+	{
+		if (args.isEmpty() || (!args.at(0).toString().isEmpty() && args.at(0).toString()!=controlInterface))
+		{
+			sendError(message, connection, QDBusError::UnknownInterface, QString("No such interface %1").arg(args.value(0).toString()));
+			return (true);
+		}
+
+		const QVariantMap state = controlState(md);
+		if (member=="GetAll")
+		{
+			sendReply(message, connection, state);
+			return (true);
+		}
+
+		const QString name = args.value(1).toString();
+		if (!state.contains(name))
+		{
+			sendError(message, connection, QDBusError::UnknownProperty, QString("No such property %1").arg(name));
+			return (true);
+		}
+
+		if (member=="Get")
+		{
+			sendReply(message, connection, QVariant::fromValue(QDBusVariant(state.value(name))));
+			return (true);
+		}
+
+		if (member=="Set" && args.count()==3)
+		{
+			const QVariant value = qvariant_cast<QDBusVariant>(args.at(2)).variant();
+			if (!isWritableProperty(name))
+			{
+				sendError(message, connection, QDBusError::PropertyReadOnly, QString("Property %1 is read only").arg(name));
+				return (true);
+			}
+
+			const QString error = checkControlProperty(name, value);
+			if (!error.isEmpty()) sendError(message, connection, QDBusError::InvalidArgs, error);
+			else
+			{
+				setControlProperty(md, name, value);
+				sendReply(message, connection);
+			}
+			return (true);
+		}
+	}
+	else if (interface.isEmpty() || interface==controlInterface)
+	{
+		if (member=="increaseVolume")
+		{
+			md->mixer()->increaseVolume(md->id());
+			sendReply(message, connection);
+			return (true);
+		}
+
+		if (member=="decreaseVolume")
+		{
+			md->mixer()->decreaseVolume(md->id());
+			sendReply(message, connection);
+			return (true);
+		}
+
+		if (member=="toggleMute")
+		{
+			md->toggleMute();
+			md->mixer()->commitVolumeChange(md);
+			sendReply(message, connection);
+			return (true);
+		}
+	}
+
+	sendError(message, connection, QDBusError::UnknownMethod, QString("No such method %1.%2").arg(interface, member));
+	return (true);
+}
+
+
+/**
+ * Set a writable property of a control and commit it to the hardware.
+ *
+ * @return @c true if the property was set, @c false if it is not writable
+ */
+bool DBusMixerObject::setControlProperty(shared_ptr<MixDevice> md, const QString &name, const QVariant &value)
+{
+	if (!applyControlProperty(md, name, value)) return (false);
+	md->mixer()->commitVolumeChange(md);
+	return (true);
+}
+
+
+/**
+ * Set a writable property of a control, without committing it to the hardware.
+ *
+ * @return @c true if the property was set, @c false if it is not writable
+ */
+bool DBusMixerObject::applyControlProperty(shared_ptr<MixDevice> md, const QString &name, const QVariant &value)
+{
+	if (name=="volume")
+	{
+		const int percentage = value.toInt();
+		Volume& volP = md->playbackVolume();
+		Volume& volC = md->captureVolume();
+		volP.setAllVolumes( volP.minVolume() + ((percentage * volP.volumeSpan()) / 100) );
+		volC.setAllVolumes( volC.minVolume() + ((percentage * volC.volumeSpan()) / 100) );
+	}
+	else if (name=="absoluteVolume")
+	{
+		const long absoluteVolume = value.toLongLong();
+		md->playbackVolume().setAllVolumes( absoluteVolume );
+		md->captureVolume().setAllVolumes( absoluteVolume );
+	}
+	else if (name=="mute")
+	{
+		md->setMuted(value.toBool());
+	}
+	else if (name=="recordSource")
+	{
+		md->setRecSource(value.toBool());
+	}
+	else return (false);
+
+	return (true);
+}
+
+
+bool DBusMixerObject::isWritableProperty(const QString &name)
+{
+	return (name=="volume" || name=="absoluteVolume" || name=="mute" || name=="recordSource");
+}
+
+
+/**
+ * Check that a property of a control can be set to a value.  QVariant
+ * would convert nearly anything to an integer or a bool, so only the
+ * D-Bus numeric types are accepted for the volumes, and only a boolean
+ * for the switches.
+ *
+ * @return an error message, or an empty string if the value can be set
+ */
+QString DBusMixerObject::checkControlProperty(const QString &name, const QVariant &value)
+{
+	const int type = value.userType();
+	if (name=="volume" || name=="absoluteVolume")
+	{
+		switch (type)
+		{
+case QMetaType::UChar:
+case QMetaType::Short:
+case QMetaType::UShort:
+case QMetaType::Int:
+case QMetaType::UInt:
+case QMetaType::LongLong:
+case QMetaType::ULongLong:
+case QMetaType::Double:
+			return (QString());
+
+default:
+			return (QString("Property %1 must be a number").arg(name));
+		}
+	}
+
+	if (name=="mute" || name=="recordSource")
+	{
+		if (type==QMetaType::Bool) return (QString());
+		return (QString("Property %1 must be a boolean").arg(name));
+	}
+
+	Q_ASSERT(!isWritableProperty(name));
+	return (QString("Property %1 cannot be set").arg(name));
+}
+
+
+QVariantMap DBusMixerObject::controlState(shared_ptr<MixDevice> md)
+{
+	Volume &useVolume = (md->playbackVolume().count() != 0) ? md->playbackVolume() : md->captureVolume();
+	const qreal avgVol = useVolume.getAvgVolume(Volume::MALL);
+
+	QVariantMap state;
+	state.insert("id", md->id());
+	state.insert("readableName", md->readableName());
+	state.insert("iconName", md->iconName());
+	state.insert("volume", useVolume.getAvgVolumePercent(Volume::MALL));
+	state.insert("absoluteVolume", static_cast<int>(avgVol <0 ? avgVol-.5 : avgVol+.5));
+	state.insert("absoluteVolumeMin", static_cast<int>(useVolume.minVolume()));
+	state.insert("absoluteVolumeMax", static_cast<int>(useVolume.maxVolume()));
+	state.insert("mute", md->isMuted());
+	state.insert("canMute", md->hasMuteSwitch());
+	state.insert("recordSource", md->isRecSource());
+	state.insert("hasCaptureSwitch", md->captureVolume().hasSwitch());
+	return (state);
+}
@@ -0,0 +1,93 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * Copyright 1996-2004 Christian Esken <esken@kde.org>
+ * Copyright 2011 Igor Poboiko <igor.poboiko@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef DBUS_MIXER_OBJECT_H
+#define DBUS_MIXER_OBJECT_H
+
+#include <QDBusVirtualObject>
+#include <QHash>
+#include <QVariantMap>
+#include "core/mixdevice.h"
+
+class Mixer;
+class DBusMixerWrapper;
+
+/**
+ * Serves the D-Bus object subtree of one mixer: the mixer object itself
+ * and one org.kde.KMix.Control object for each of its controls.
+ *
+ * Nothing is created or registered for each control.  Messages for a
+ * control path are dispatched directly to the corresponding MixDevice,
+ * so controls can come and go (as PulseAudio streams do) without any
+ * D-Bus work.  Messages for the mixer path are dispatched to the
+ * DBusMixerWrapper, which implements the org.kde.KMix.Mixer interface.
+ */
+class DBusMixerObject : public QDBusVirtualObject
+{
+	Q_OBJECT
+
+	public:
+		DBusMixerObject(Mixer *mixer, const QString &path, DBusMixerWrapper *mixerWrapper);
+		~DBusMixerObject();
+
+		QString introspect(const QString &path) const override;
+		bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection) override;
+
+		/**
+		 * Must be called when controls have been added or removed.
+		 */
+		void controlsChanged()				{ m_controlsValid = false; }
+
+		/**
+		 * The current values of all of the properties of the
+		 * org.kde.KMix.Control interface for a control, keyed
+		 * by the property name.
+		 */
+		static QVariantMap controlState(shared_ptr<MixDevice> md);
+
+		// Writable properties of the org.kde.KMix.Control interface
+		static bool applyControlProperty(shared_ptr<MixDevice> md, const QString &name, const QVariant &value);
+		static bool isWritableProperty(const QString &name);
+		static QString checkControlProperty(const QString &name, const QVariant &value);
+
+		/**
+		 * Find a control of this mixer by its D-Bus path.
+		 */
+		shared_ptr<MixDevice> findControl(const QString &path) const;
+
+	private:
+		void updateControls() const;
+
+		QVariantMap mixerState() const;
+		bool handleMixerMessage(const QDBusMessage &message, const QDBusConnection &connection);
+		bool handleControlMessage(shared_ptr<MixDevice> md, const QDBusMessage &message, const QDBusConnection &connection);
+		static bool setControlProperty(shared_ptr<MixDevice> md, const QString &name, const QVariant &value);
+
+		Mixer *m_mixer;
+		QString m_path;
+		DBusMixerWrapper *m_mixerWrapper;
+
+		// The control IDs, keyed by the last element of their D-Bus path
+		mutable QHash<QString,QString> m_controls;
+		mutable bool m_controlsValid;
+};
+
+#endif /* DBUS_MIXER_OBJECT_H */
@@ -24,21 +24,35 @@
 #include <QStringList>
 
 #include "core/ControlManager.h"
+#include "core/kmixstats.h"
+#include "core/kmixtrace.h"
 #include "core/mixdevice.h"
 #include "core/volume.h"
 #include "kmix_debug.h"
+#include "settings.h"
+#include "dbus/dbusmixerobject.h"
 #include "dbus/dbusmixsetwrapper.h"
-#include "mixeradaptor.h"
 
 DBusMixerWrapper::DBusMixerWrapper(Mixer* parent, const QString& path)
 	: QObject(parent)
 	, m_dbusPath(path)
+	, m_signalsSent(0)
+	, m_signalsSuppressed(0)
 {
 	m_mixer = parent;
-	new MixerAdaptor( this );
+	m_signalTimer.setSingleShot(true);
+	connect(&m_signalTimer, &QTimer::timeout, this, &DBusMixerWrapper::refreshVolumeLevels);
+
+	registerDBusTypes();
 	qCDebug(KMIX_LOG) << "Create QDBusConnection for object " << path;
-	QDBusConnection::sessionBus().registerObject( path, this );
-	
+	// The mixer and all of its controls are served by this one object
+	m_mixerObject = new DBusMixerObject(m_mixer, path, this);
+	updateVolumeStates();
+
+	// There is no way to know whether anybody is listening to the signals,
+	// so do not keep the mixer polled just for them.  This is set before
+	// adding the listener, so that adding it does not resume polling.
+	ControlManager::instance().setListenerActive(this, false);
 	ControlManager::instance().addListener(
 		m_mixer->id(),
 		ControlManager::ControlList|ControlManager::Volume,
@@ -62,11 +76,13 @@ void DBusMixerWrapper::controlsChange(ControlManager::ChangeType changeType)
 	switch (changeType)
 	{
 	case  ControlManager::ControlList:
+		// Send any suppressed change before the states are reset
+		if (m_signalTimer.isActive()) refreshVolumeLevels();
 		createDeviceWidgets();
 		break;
 	  
 	case ControlManager::Volume:
-		refreshVolumeLevels();
+		scheduleVolumeLevels();
 		break;
 	  
 	default:
@@ -128,17 +144,216 @@ QString DBusMixerWrapper::udi()
 	return m_mixer->udi();
 }
 
+/**
+ * The complete state of all controls of this mixer, so that a client
+ * can refresh with one call instead of reading every property of
+ * every control.
+ */
+ControlStateMap DBusMixerWrapper::controlStates()
+{
+	ControlStateMap result;
+	for (const shared_ptr<MixDevice> md : qAsConst(m_mixer->getMixSet()))
+	{
+		result.insert(md->dbusPath(), DBusMixerObject::controlState(md));
+	}
+	return result;
+}
+
+/**
+ * Change a number of controls at once.  The controls are keyed by their
+ * D-Bus path or control ID, and for each one any of the writable properties
+ * "volume", "absoluteVolume", "mute" and "recordSource" may be given.
+ *
+ * All of the requested changes are checked first, and if any of them
+ * is not valid then nothing is changed.  Otherwise they are committed
+ * with a single write to the backend and a single announcement.
+ *
+ * @return the status for each control, empty if it was set successfully
+ */
+ControlStatusMap DBusMixerWrapper::setControlStates(const ControlStateMap &states)
+{
+	ControlStatusMap result;
+	QHash<QString,shared_ptr<MixDevice> > found;		// keyed as in states
+	QList<shared_ptr<MixDevice> > mds;
+	bool valid = true;
+
+	for (ControlStateMap::const_iterator it = states.constBegin(); it!=states.constEnd(); ++it)
+	{
+		const QString &key = it.key();
+		shared_ptr<MixDevice> md = key.startsWith('/') ? m_mixerObject->findControl(key) : m_mixer->getMixdeviceById(key);
+		if (!md)
+		{
+			result.insert(key, QString("No such control"));
+			valid = false;
+			continue;
+		}
+
+		const QVariantMap &props = it.value();
+		for (QVariantMap::const_iterator prop = props.constBegin(); prop!=props.constEnd(); ++prop)
+		{
+			const QString error = DBusMixerObject::checkControlProperty(prop.key(), prop.value());
+			if (!error.isEmpty())
+			{
+				result.insert(key, error);
+				valid = false;
+				break;
+			}
+		}
+
+		found.insert(key, md);
+		if (!mds.contains(md)) mds.append(md);
+	}
+
+	if (!valid)
+	{
+		for (const QString &key : states.keys())
+		{
+			if (!result.contains(key)) result.insert(key, QString("Not changed"));
+		}
+		return (result);
+	}
+
+	for (ControlStateMap::const_iterator it = states.constBegin(); it!=states.constEnd(); ++it)
+	{
+		shared_ptr<MixDevice> md = found.value(it.key());
+		const QVariantMap &props = it.value();
+		for (QVariantMap::const_iterator prop = props.constBegin(); prop!=props.constEnd(); ++prop)
+		{
+			DBusMixerObject::applyControlProperty(md, prop.key(), prop.value());
+		}
+	}
+
+	const QList<int> written = m_mixer->commitVolumeChanges(mds);
+	for (const QString &key : states.keys())
+	{
+		const int err = written.value(mds.indexOf(found.value(key)), Mixer::OK);
+		if (err==Mixer::OK || err==Mixer::OK_UNCHANGED) result.insert(key, QString());
+		else result.insert(key, QString("Write failed (error %1)").arg(err));
+	}
+	return (result);
+}
+
+DBusMixerWrapper::VolumeState DBusMixerWrapper::volumeState(shared_ptr<MixDevice> md)
+{
+	Volume &useVolume = (md->playbackVolume().count() != 0) ? md->playbackVolume() : md->captureVolume();
+	const qreal avgVol = useVolume.getAvgVolume(Volume::MALL);
+
+	VolumeState state;
+	state.volume = useVolume.getAvgVolumePercent(Volume::MALL);
+	state.absoluteVolume = static_cast<int>(avgVol <0 ? avgVol-.5 : avgVol+.5);
+	state.mute = md->isMuted();
+	state.recordSource = md->isRecSource();
+	return (state);
+}
+
+/**
+ * Remember the current state of all controls, without sending anything.
+ * Used initially and when the list of controls changes, so that the
+ * next change signal only reports what changed after that.
+ */
+void DBusMixerWrapper::updateVolumeStates()
+{
+	m_volumeStates.clear();
+	for (const shared_ptr<MixDevice> md : qAsConst(m_mixer->getMixSet()))
+	{
+		m_volumeStates.insert(md->id(), volumeState(md));
+	}
+}
+
+/**
+ * Send the change signals for a Volume announcement, but no more often
+ * than the configured DBusSignalMaxRate.  A change that arrives too soon
+ * after the previous one is suppressed, and the timer makes sure that the
+ * latest state is always sent when the interval has passed.
+ */
+void DBusMixerWrapper::scheduleVolumeLevels()
+{
+	if (m_signalTimer.isActive())
+	{
+		// Already waiting, that will pick up this change too
+		++m_signalsSuppressed;
+		return;
+	}
+
+	const int maxRate = Settings::dBusSignalMaxRate();
+	const qint64 minInterval = (maxRate>0) ? (1000/maxRate) : 0;
+	const qint64 elapsed = m_sinceSignal.isValid() ? m_sinceSignal.elapsed() : minInterval;
+	if (elapsed>=minInterval)
+	{
+		refreshVolumeLevels();
+		return;
+	}
+
+	++m_signalsSuppressed;
+	if (Settings::debugControlManager())
+		qCDebug(KMIX_LOG) << "Suppressed change signal for" << m_mixer->id() << "total" << m_signalsSuppressed;
+	m_signalTimer.start(minInterval-elapsed);
+}
+
 void DBusMixerWrapper::refreshVolumeLevels()
 {
+	KMixTrace::Span span("refreshVolumeLevels", "dbus", m_mixer->id());
+	m_signalTimer.stop();
+	m_sinceSignal.start();
+	++m_signalsSent;
+
 	QDBusMessage signal = QDBusMessage::createSignal( m_dbusPath, 
 				"org.kde.KMix.Mixer", "controlChanged" );
 	QDBusConnection::sessionBus().send( signal );
+	KMixStats::count(KMixStats::DBusSignals);
+
+	// Find out which controls have actually changed, and send their
+	// new state so that subscribers do not need to query them.
+	ControlStateMap changedStates;
+	for (const shared_ptr<MixDevice> md : qAsConst(m_mixer->getMixSet()))
+	{
+		const VolumeState newState = volumeState(md);
+		QHash<QString,VolumeState>::iterator it = m_volumeStates.find(md->id());
+		const bool isNew = (it==m_volumeStates.end());
+
+		QVariantMap changedProperties;
+		if (isNew || it->volume!=newState.volume) changedProperties.insert("volume", newState.volume);
+		if (isNew || it->absoluteVolume!=newState.absoluteVolume) changedProperties.insert("absoluteVolume", newState.absoluteVolume);
+		if (isNew || it->mute!=newState.mute) changedProperties.insert("mute", newState.mute);
+		if (isNew || it->recordSource!=newState.recordSource) changedProperties.insert("recordSource", newState.recordSource);
+		if (changedProperties.isEmpty()) continue;
+
+		m_volumeStates.insert(md->id(), newState);
+
+		const QString controlPath = md->dbusPath();
+		QDBusMessage propertiesSignal = QDBusMessage::createSignal(controlPath,
+				"org.freedesktop.DBus.Properties", "PropertiesChanged");
+		propertiesSignal << QString("org.kde.KMix.Control") << changedProperties << QStringList();
+		QDBusConnection::sessionBus().send(propertiesSignal);
+		KMixStats::count(KMixStats::DBusSignals);
+
+		QVariantMap state;
+		state.insert("volume", newState.volume);
+		state.insert("absoluteVolume", newState.absoluteVolume);
+		state.insert("mute", newState.mute);
+		state.insert("recordSource", newState.recordSource);
+		changedStates.insert(controlPath, state);
+	}
+
+	if (!changedStates.isEmpty())
+	{
+		QDBusMessage statesSignal = QDBusMessage::createSignal(m_dbusPath,
+				"org.kde.KMix.Mixer", "controlStatesChanged");
+		statesSignal << QVariant::fromValue(changedStates);
+		QDBusConnection::sessionBus().send(statesSignal);
+		KMixStats::count(KMixStats::DBusSignals);
+	}
 }
 
 void DBusMixerWrapper::createDeviceWidgets()
 {
+	KMixTrace::Span span("createDeviceWidgets", "dbus", m_mixer->id());
+	m_mixerObject->controlsChanged();
+	updateVolumeStates();
+
 	QDBusMessage signal = QDBusMessage::createSignal( m_dbusPath, 
 				"org.kde.KMix.Mixer", "changed" );
 	QDBusConnection::sessionBus().send( signal );
+	KMixStats::count(KMixStats::DBusSignals);
 }
 
@@ -22,11 +22,17 @@
 #ifndef DBUSMIXERWRAPPER_H
 #define DBUSMIXERWRAPPER_H
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QObject>
 #include <QStringList>
+#include <QTimer>
 
 #include "core/mixer.h"
 #include "core/ControlManager.h"
+#include "dbus/dbustypes.h"
+
+class DBusMixerObject;
 
 class DBusMixerWrapper : public QObject
 {
@@ -39,6 +45,8 @@ class DBusMixerWrapper : public QObject
 	Q_PROPERTY(QString udi READ udi)
 	Q_PROPERTY(int balance READ balance WRITE setBalance)
 	Q_PROPERTY(QStringList controls READ controls)
+	Q_PROPERTY(uint signalsSent READ signalsSent)
+	Q_PROPERTY(uint signalsSuppressed READ signalsSuppressed)
 
 	public:
 		DBusMixerWrapper(Mixer* parent, const QString& path);
@@ -55,13 +63,43 @@ class DBusMixerWrapper : public QObject
 
 		int balance();
 		void setBalance(int balance);
+
+		uint signalsSent() const			{ return (m_signalsSent); }
+		uint signalsSuppressed() const			{ return (m_signalsSuppressed); }
+
+		ControlStateMap controlStates();
+		ControlStatusMap setControlStates(const ControlStateMap &states);
 	public slots:
 		void controlsChange(ControlManager::ChangeType changeType);
+	private slots:
+		void refreshVolumeLevels();
 	private:
+		/**
+		 * The part of the state of a control that changes on a
+		 * Volume announcement, as last sent to D-Bus.
+		 */
+		struct VolumeState
+		{
+			int volume;
+			int absoluteVolume;
+			bool mute;
+			bool recordSource;
+		};
+
+		static VolumeState volumeState(shared_ptr<MixDevice> md);
+		void updateVolumeStates();
+
 		void createDeviceWidgets();
-		void refreshVolumeLevels();
+		void scheduleVolumeLevels();
 		Mixer *m_mixer;
 		QString m_dbusPath;
+		DBusMixerObject *m_mixerObject;
+		QHash<QString,VolumeState> m_volumeStates;	// keyed by control ID
+
+		QTimer m_signalTimer;				// for a suppressed change
+		QElapsedTimer m_sinceSignal;			// since the last change sent
+		uint m_signalsSent;
+		uint m_signalsSuppressed;
 };
 
 #endif /* DBUSMIXERWRAPPER_H */
@@ -22,6 +22,9 @@
 
 #include "core/mixdevice.h"
 #include "core/ControlManager.h"
+#include "core/kmixstats.h"
+#include "core/kmixtrace.h"
+#include "dbus/dbusmixerobject.h"
 #include "mixsetadaptor.h"
 
 static DBusMixSetWrapper *instanceSingleton = nullptr;
@@ -40,6 +43,7 @@ DBusMixSetWrapper::DBusMixSetWrapper(QObject* parent, const QString& path)
 	: QObject(parent)
 	, m_dbusPath( path )
 {
+	registerDBusTypes();
 	new MixSetAdaptor( this );
 	QDBusConnection::sessionBus().registerObject( m_dbusPath, this );
 	
@@ -69,6 +73,23 @@ QStringList DBusMixSetWrapper::mixers() const
 	return result;
 }
 
+/**
+ * The complete state of all controls of all mixers.  As the control
+ * paths include the mixer path, they are unique across all mixers.
+ */
+ControlStateMap DBusMixSetWrapper::controlStates() const
+{
+	ControlStateMap result;
+	for (Mixer *mixer : qAsConst(Mixer::mixers()))
+	{
+		for (const shared_ptr<MixDevice> md : qAsConst(mixer->getMixSet()))
+		{
+			result.insert(md->dbusPath(), DBusMixerObject::controlState(md));
+		}
+	}
+	return result;
+}
+
 QString DBusMixSetWrapper::currentMasterMixer() const
 {
 	Mixer* masterMixer = Mixer::getGlobalMasterMixer();
@@ -105,13 +126,17 @@ void DBusMixSetWrapper::signalMixersChanged()
 {
 	QDBusMessage signal = QDBusMessage::createSignal( m_dbusPath, 
 			"org.kde.KMix.MixSet", "mixersChanged" );
+	KMixTrace::instant("mixersChanged", "dbus");
 	QDBusConnection::sessionBus().send( signal );
+	KMixStats::count(KMixStats::DBusSignals);
 }
 
 void DBusMixSetWrapper::signalMasterChanged()
 {
 	QDBusMessage signal = QDBusMessage::createSignal( m_dbusPath, 
 			"org.kde.KMix.MixSet", "masterChanged" );
+	KMixTrace::instant("masterChanged", "dbus");
 	QDBusConnection::sessionBus().send( signal );
+	KMixStats::count(KMixStats::DBusSignals);
 }
 
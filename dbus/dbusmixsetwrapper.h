@@ -24,6 +24,7 @@
 #include <QStringList>
 #include "core/mixer.h"
 #include "core/ControlManager.h"
+#include "dbus/dbustypes.h"
 #include "kmixcore_export.h"
 
 class KMIXCORE_EXPORT DBusMixSetWrapper : public QObject
@@ -44,6 +45,7 @@ class KMIXCORE_EXPORT DBusMixSetWrapper : public QObject
 
 	public slots:
 		QStringList mixers() const;
+		ControlStateMap controlStates() const;
 		
 		QString currentMasterMixer() const;
 		QString currentMasterControl() const;
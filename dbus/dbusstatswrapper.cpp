@@ -0,0 +1,53 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "dbusstatswrapper.h"
+
+#include <QDBusConnection>
+
+#include "core/kmixstats.h"
+#include "core/kmixtrace.h"
+#include "statsadaptor.h"
+
+DBusStatsWrapper::DBusStatsWrapper(QObject *parent, const QString &path)
+	: QObject(parent)
+{
+	new StatsAdaptor(this);
+	QDBusConnection::sessionBus().registerObject(path, this);
+}
+
+QVariantMap DBusStatsWrapper::values() const
+{
+	return (KMixStats::values());
+}
+
+void DBusStatsWrapper::reset()
+{
+	KMixStats::reset();
+}
+
+void DBusStatsWrapper::startTrace()
+{
+	KMixTrace::setEnabled(true);
+}
+
+bool DBusStatsWrapper::stopTrace(const QString &fileName)
+{
+	KMixTrace::setEnabled(false);
+	return (KMixTrace::write(fileName));
+}
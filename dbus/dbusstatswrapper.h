@@ -0,0 +1,48 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef DBUSSTATSWRAPPER_H
+#define DBUSSTATSWRAPPER_H
+
+#include <QObject>
+#include <QVariantMap>
+
+#include "kmixcore_export.h"
+
+/**
+ * Publishes the KMixStats values as the org.kde.KMix.Stats interface.
+ */
+class KMIXCORE_EXPORT DBusStatsWrapper : public QObject
+{
+	Q_OBJECT
+
+	public:
+		DBusStatsWrapper(QObject *parent, const QString &path);
+		virtual ~DBusStatsWrapper() = default;
+
+	public slots:
+		QVariantMap values() const;
+		void reset();
+
+		/// Start recording a trace of the change pipeline
+		void startTrace();
+		/// Stop recording, and write the trace to @p fileName
+		bool stopTrace(const QString &fileName);
+};
+
+#endif /* DBUSSTATSWRAPPER_H */
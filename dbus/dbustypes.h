@@ -0,0 +1,65 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef DBUSTYPES_H
+#define DBUSTYPES_H
+
+#include <QMap>
+#include <QMetaType>
+#include <QString>
+#include <QVariantMap>
+
+#include <QDBusMetaType>
+
+/**
+ * The state of a number of controls, keyed by the D-Bus path of each
+ * control.  The value for each control maps the names of the properties
+ * of the org.kde.KMix.Control interface to their current values.
+ *
+ * The D-Bus signature is a{sa{sv}}.
+ */
+typedef QMap<QString,QVariantMap> ControlStateMap;
+
+Q_DECLARE_METATYPE(ControlStateMap)
+
+/**
+ * The result of an operation on a number of controls, keyed by the
+ * D-Bus path of each control.  The value is empty if the operation
+ * succeeded for that control, otherwise it describes the error.
+ *
+ * The D-Bus signature is a{ss}.
+ */
+typedef QMap<QString,QString> ControlStatusMap;
+
+Q_DECLARE_METATYPE(ControlStatusMap)
+
+/**
+ * Register the custom types used in the KMix D-Bus interfaces.
+ * This may safely be called more than once.
+ */
+inline void registerDBusTypes()
+{
+	static bool registered = false;
+	if (registered) return;
+
+	qDBusRegisterMetaType<ControlStateMap>();
+	qDBusRegisterMetaType<ControlStatusMap>();
+	registered = true;
+}
+
+#endif /* DBUSTYPES_H */
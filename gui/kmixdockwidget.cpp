@@ -86,9 +86,10 @@ KMixDockWidget::KMixDockWidget(KXmlGuiWindow *parent)
 
     ControlManager::instance().addListener(
 	    QString(),					// All mixers (as the global master mixer might change)
-	    ControlManager::Volume|ControlManager::MasterChanged,
+	    ControlManager::MasterChanged,
 	    this,
 	    QString("KMixDockWidget"));
+    listenToMaster();
 
     // Refresh in all cases. When there is no global master we still need
     // to initialize correctly (e.g. for showing 0% or hiding it)
@@ -140,6 +141,7 @@ case ControlManager::MasterChanged:
 		//{
 		//    qCWarning(KMIX_LOG) << "select_master action not found. Cannot enable it in the Systray.";
 		//}
+		listenToMaster();
 		Q_FALLTHROUGH();
 
 case ControlManager::Volume:
@@ -151,6 +153,24 @@ default:	ControlManager::warnUnexpectedChangeType(changeType, this);
 	}
 }
 
+/**
+ * Only volume changes of the global master mixer are shown, so only listen
+ * to those.  Then the other mixers do not need to be polled for the icon.
+ */
+void KMixDockWidget::listenToMaster()
+{
+	// Remove only the listener for ControlManager::Volume,
+	// retaining the one for ControlManager::MasterChanged.
+	ControlManager::instance().removeListener(this, ControlManager::Volume, "KMixDockWidget");
+
+	const Mixer *globalMaster = Mixer::getGlobalMasterMixer();
+	if (globalMaster==nullptr) return;
+	ControlManager::instance().addListener(globalMaster->id(),
+					       ControlManager::Volume,
+					       this,
+					       QString("KMixDockWidget (volume)"));
+}
+
 /**
  * Updates all visual parts of the volume control, namely tooltip and pixmap
  */
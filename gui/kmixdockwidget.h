@@ -65,6 +65,7 @@ private:
 private:
     bool onlyHaveOneMouseButtonAction() const;
     void refreshVolumeLevels();
+    void listenToMaster();
     void createWidgets();
     void setVolumeTip();
     void updatePixmap();
@@ -35,6 +35,7 @@
 #include <QAction>
 
 #include "core/ControlManager.h"
+#include "core/kmixtrace.h"
 #include "core/mixer.h"
 #include "gui/guiprofile.h"
 #include "gui/volumeslider.h"
@@ -65,7 +66,8 @@ MDWSlider::MDWSlider(shared_ptr<MixDevice> md, MixDeviceWidget::MDWFlags flags,
 	  m_controlButtonSize(QSize()),
 	  m_moveMenu(nullptr),
 	  m_sliderInWork(false),
-	  m_waitForSoundSetComplete(0)
+	  m_waitForSoundSetComplete(0),
+	  m_renderedValid(false)
 {
 	//qCDebug(KMIX_LOG) << "for" << mixDevice()->readableName() << "flags" << MixDeviceWidget::flags();
 
@@ -570,6 +572,8 @@ void MDWSlider::updateMediaButton()
 
 	MediaController *mediaController =  mixDevice()->mediaController();
 	QString mediaIconName = calculatePlaybackIcon(mediaController->getPlayState());
+	if (mediaIconName==m_renderedMediaIcon) return;	// no change
+	m_renderedMediaIcon = mediaIconName;
 	ToggleToolButton::setIndicatorIcon(mediaIconName, m_mediaPlayButton);
 }
 
@@ -697,12 +701,14 @@ void MDWSlider::addSliders( QBoxLayout *volLayout, char type, Volume& vol,
 void MDWSlider::sliderPressed()
 {
   m_sliderInWork = true;
+  invalidateRendered();
 }
 
 
 void MDWSlider::sliderReleased()
 {
   m_sliderInWork = false;
+  invalidateRendered();
 }
 
 
@@ -729,6 +735,7 @@ MDWSlider::setStereoLinked(bool value)
 	bool showSubcontrolLabels = (overallSlidersToShow >= 2);
 	setStereoLinkedInternal(m_slidersPlayback, showSubcontrolLabels);
 	setStereoLinkedInternal(m_slidersCapture  , showSubcontrolLabels);
+	invalidateRendered();
 	update(); // Call update(), so that the sliders can adjust EITHER to the individual values OR the average value.
 }
 
@@ -833,6 +840,7 @@ MDWSlider::setIcons(bool value)
 /** This slot is called, when a user has changed the volume via the KMix Slider. */
 void MDWSlider::volumeChange( int )
 {
+	invalidateRendered();
 	if (!m_slidersPlayback.isEmpty())
 	{
 		++m_waitForSoundSetComplete;
@@ -880,6 +888,7 @@ void MDWSlider::toggleRecsrc()
 
 void MDWSlider::setRecsrc(bool value)
 {
+	invalidateRendered();
 	if ( mixDevice()->captureVolume().hasSwitch() )
 	{
 		mixDevice()->setRecSource( value );
@@ -899,6 +908,7 @@ void MDWSlider::toggleMuted()
 
 void MDWSlider::setMuted(bool value)
 {
+	invalidateRendered();
 	if ( mixDevice()->hasMuteSwitch() )
 	{
 		mixDevice()->setMuted( value );
@@ -935,6 +945,7 @@ void MDWSlider::decreaseVolume()
  */
 void MDWSlider::increaseOrDecreaseVolume(bool decrease, Volume::VolumeTypeFlag volumeType)
 {
+	invalidateRendered();
 	mixDevice()->increaseOrDecreaseVolume(decrease, volumeType);
 	// I should possibly not block, as the changes that come back from the Soundcard
 	//      will be ignored (e.g. because of capture groups)
@@ -961,23 +972,87 @@ void MDWSlider::moveStream(bool checked)
 
 /**
  * This is called whenever there are volume updates pending from the hardware for this MDW.
+ *
+ * If nothing that is shown has changed since the last update, no widget
+ * is touched.  Otherwise the widget updates are done with painting held
+ * off, so that they result in a single repaint of this MDW.
  */
 void MDWSlider::update()
 {
+	KMixTrace::Span span("MDWSlider::update", "gui", mixDevice()->id());
+
+	const RenderedState state = currentState();
+	if (m_renderedValid && state==m_rendered) return;	// nothing to do
+	const bool nameChanged = (!m_renderedValid || state.name!=m_rendered.name);
+	const bool linkChanged = (!m_renderedValid || state.linked!=m_rendered.linked);
+
+	const bool wasEnabled = updatesEnabled();
+	setUpdatesEnabled(false);
+
 	if ( m_slidersPlayback.count() != 0 || mixDevice()->hasMuteSwitch() )
 		updateInternal(mixDevice()->playbackVolume(), m_slidersPlayback, mixDevice()->isMuted() );
 	if ( m_slidersCapture.count()  != 0 || mixDevice()->captureVolume().hasSwitch() )
 		updateInternal(mixDevice()->captureVolume(), m_slidersCapture, mixDevice()->isNotRecSource() );
-	if (m_controlLabel!=nullptr)
+	if (nameChanged)
 	{
-		QLabel *l;
-		VerticalText *v;
-		if ((l = dynamic_cast<QLabel*>(m_controlLabel)))
-			l->setText(mixDevice()->readableName());
-		else if ((v = dynamic_cast<VerticalText*>(m_controlLabel)))
-			v->setText(mixDevice()->readableName());
+		if (m_controlLabel!=nullptr)
+		{
+			QLabel *l;
+			VerticalText *v;
+			if ((l = dynamic_cast<QLabel*>(m_controlLabel)))
+				l->setText(state.name);
+			else if ((v = dynamic_cast<VerticalText*>(m_controlLabel)))
+				v->setText(state.name);
+		}
+	}
+#ifndef QT_NO_ACCESSIBILITY
+	if (nameChanged || linkChanged) updateAccesability();
+#endif
+
+	setUpdatesEnabled(wasEnabled);
+
+	// While the user is moving a slider or a change is still on its way
+	// to the hardware, the sliders may not show the hardware state.  Only
+	// remember the state if they do, so that a later update is not skipped.
+	m_rendered = state;
+	m_renderedValid = (!m_sliderInWork && m_waitForSoundSetComplete<1);
+}
+
+
+bool MDWSlider::RenderedState::operator==(const RenderedState &other) const
+{
+	return (muted==other.muted && recSource==other.recSource && linked==other.linked &&
+		playback==other.playback && capture==other.capture && name==other.name);
+}
+
+
+/**
+ * The values that update() would show for the current state of the mix device.
+ */
+MDWSlider::RenderedState MDWSlider::currentState() const
+{
+	shared_ptr<MixDevice> md = mixDevice();
+
+	RenderedState state;
+	state.muted = md->isMuted();
+	state.recSource = md->isRecSource();
+	state.name = md->readableName();
+	state.linked = m_linked;
+	appendSliderValues(state.playback, md->playbackVolume(), m_slidersPlayback, state.muted);
+	appendSliderValues(state.capture, md->captureVolume(), m_slidersCapture, md->isNotRecSource());
+	return (state);
+}
+
+
+void MDWSlider::appendSliderValues(QList<long> &values, const Volume &vol,
+                                   const QList<QAbstractSlider *> &ref_sliders, bool muted)
+{
+	for (const QAbstractSlider *s : ref_sliders)
+	{
+		const VolumeSlider *slider = qobject_cast<const VolumeSlider *>(s);
+		if (slider==nullptr) continue;
+		values.append(muted ? 0 : vol.getVolumeForGUI(slider->channelId()));
 	}
-	updateAccesability();
 }
 
 /**
@@ -112,6 +112,7 @@ private:
     void setTicksInternal( QList< QAbstractSlider* >& ref_sliders, bool ticks );
     void volumeChangeInternal(Volume& vol, QList< QAbstractSlider* >& ref_sliders );
     void updateInternal(Volume& vol, QList< QAbstractSlider* >& ref_sliders, bool muted);
+    void invalidateRendered()				{ m_renderedValid = false; }
 #ifndef QT_NO_ACCESSIBILITY
     void updateAccesability();
 #endif
@@ -146,6 +147,29 @@ private:
     bool m_sliderInWork;
     int m_waitForSoundSetComplete;
     QList<int> volumeValues;
+
+    /**
+     * What update() last showed, so that an update which would
+     * change nothing can return without touching any widget.
+     */
+    struct RenderedState
+    {
+        QList<long> playback;
+        QList<long> capture;
+        bool muted = false;
+        bool recSource = false;
+        bool linked = true;
+        QString name;
+
+        bool operator==(const RenderedState &other) const;
+    };
+    RenderedState currentState() const;
+    static void appendSliderValues(QList<long> &values, const Volume &vol,
+                                   const QList<QAbstractSlider *> &ref_sliders, bool muted);
+
+    RenderedState m_rendered;
+    bool m_renderedValid;
+    QString m_renderedMediaIcon;
 };
 
 #endif
@@ -25,6 +25,8 @@
 #include <qcursor.h>
 #include <QMenu>
 #include <QMouseEvent>
+#include <QShowEvent>
+#include <QHideEvent>
 
 // KDE
 #include <klocalizedstring.h>
@@ -71,6 +73,9 @@ ViewBase::ViewBase(QWidget* parent, const QString &id, Qt::WindowFlags f, ViewBa
    }
    _localActionColletion = new KActionCollection( this );
 
+   // Not shown yet, so this view does not need to see volume changes
+   ControlManager::instance().setListenerActive(this, false);
+
    // Plug in the "showMenubar" action, if the caller wants it. Typically this is only necessary for views in the KMix main window.
    if ( vflags & ViewBase::HasMenuBar )
    {
@@ -252,6 +257,18 @@ void ViewBase::contextMenuEvent(QContextMenuEvent *ev)
     showContextMenu();
 }
 
+void ViewBase::showEvent(QShowEvent *ev)
+{
+    ControlManager::instance().setListenerActive(this, true);
+    QWidget::showEvent(ev);
+}
+
+void ViewBase::hideEvent(QHideEvent *ev)
+{
+    ControlManager::instance().setListenerActive(this, false);
+    QWidget::hideEvent(ev);
+}
+
 /**
  * Return a popup menu. This contains basic entries.
  * More can be added by the caller.
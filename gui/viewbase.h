@@ -31,6 +31,8 @@
 
 class QMenu;
 class QContextMenuEvent;
+class QHideEvent;
+class QShowEvent;
 
 class Mixer;
 class MixDevice;
@@ -148,6 +150,10 @@ protected:
     void contextMenuEvent(QContextMenuEvent *ev) override;
     virtual void showContextMenu();
 
+    // A view only counts as a consumer of volume changes while it is shown
+    void showEvent(QShowEvent *ev) override;
+    void hideEvent(QHideEvent *ev) override;
+
     // Creates a suitable representation for the given MixDevice.
     virtual QWidget *add(const shared_ptr<MixDevice>) = 0;
 
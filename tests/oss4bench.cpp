@@ -0,0 +1,235 @@
+/*
+ * KMix -- KDE's full featured mini mixer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this program; if not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Benchmark of Mixer_OSS4::readSetFromHW() against a simulated mixer,
+ * which stands in for the OSS4 ioctl() interface and counts the calls
+ * made.  For a number of controls changed between two reads, it shows
+ * the time and the SNDCTL_MIX_EXTINFO and SNDCTL_MIX_READ calls for
+ * each read.
+ *
+ * Usage: oss4bench [controls [reads]]
+ */
+
+#include "kmix_debug.h"
+#include "core/mixer.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// The backend is not exported from kmixcore, so it is compiled in here
+#include "backends/mixer_oss4.cpp"
+
+
+class SimulatedOSS4 : public Mixer_OSS4
+{
+public:
+	SimulatedOSS4(Mixer *mixer, int numControls);
+
+	int openSimulated()				{ return (open()); }
+	void readSet()					{ readSetFromHW(); }
+
+	/// Changes the value of the first @p count controls, as another client would
+	void changeControls(int count);
+
+	int extInfoCalls;
+	int readCalls;
+
+protected:
+	int openDevice(const char *path) override;
+	int mixerIoctl(unsigned long request, void *arg) override;
+
+private:
+	struct Control
+	{
+		int value;
+		int updateCounter;
+	};
+
+	// Index 0 is the MIXT_DEVROOT, as in a real mixer
+	QVector<Control> m_controls;
+	int m_mixerModifyCounter;
+};
+
+
+SimulatedOSS4::SimulatedOSS4(Mixer *mixer, int numControls)
+	: Mixer_OSS4(mixer, 0),
+	  extInfoCalls(0),
+	  readCalls(0),
+	  m_controls(numControls+1),
+	  m_mixerModifyCounter(1)
+{
+	for (int i = 0; i<m_controls.count(); ++i)
+	{
+		m_controls[i].value = (50<<16)|50;
+		m_controls[i].updateCounter = 1;
+	}
+}
+
+
+void SimulatedOSS4::changeControls(int count)
+{
+	if (count==0) return;
+
+	for (int i = 1; i<=count && i<m_controls.count(); ++i)
+	{
+		Control &control = m_controls[i];
+		const int level = (control.value & 0xffff)==50 ? 51 : 50;
+		control.value = (level<<16)|level;
+		++control.updateCounter;
+	}
+	++m_mixerModifyCounter;
+}
+
+
+int SimulatedOSS4::openDevice(const char *path)
+{
+	Q_UNUSED(path);
+	// A real descriptor, so that close() has something to close
+	return (QT_OPEN("/dev/null", O_RDWR));
+}
+
+
+int SimulatedOSS4::mixerIoctl(unsigned long request, void *arg)
+{
+	switch (request)
+	{
+case OSS_GETVERSION:
+		*static_cast<int *>(arg) = 0x040100;
+		return (0);
+
+case SNDCTL_MIX_NRMIX:
+		*static_cast<int *>(arg) = 1;
+		return (0);
+
+case SNDCTL_MIX_NREXT:
+		*static_cast<int *>(arg) = m_controls.count();
+		return (0);
+
+case SNDCTL_MIXERINFO:
+	{
+		oss_mixerinfo *mi = static_cast<oss_mixerinfo *>(arg);
+		mi->enabled = 1;
+		mi->modify_counter = m_mixerModifyCounter;
+		qstrncpy(mi->devnode, "/dev/oss/sim/mix0", sizeof(mi->devnode));
+		return (0);
+	}
+
+case SNDCTL_MIX_EXTINFO:
+	{
+		oss_mixext *ext = static_cast<oss_mixext *>(arg);
+		const int ctrl = ext->ctrl;
+		if (ctrl<0 || ctrl>=m_controls.count()) break;
+
+		++extInfoCalls;
+		const int dev = ext->dev;
+		memset(ext, 0, sizeof(*ext));
+		ext->dev = dev;
+		ext->ctrl = ctrl;
+		if (ctrl==0)
+		{
+			ext->type = MIXT_DEVROOT;
+			oss_mixext_root *root = reinterpret_cast<oss_mixext_root *>(ext->data);
+			qstrncpy(root->name, "Simulated OSS4 mixer", sizeof(root->name));
+			return (0);
+		}
+
+		ext->type = MIXT_STEREOSLIDER16;
+		ext->minvalue = 0;
+		ext->maxvalue = 100;
+		ext->flags = MIXF_READABLE|MIXF_WRITEABLE;
+		ext->update_counter = m_controls[ctrl].updateCounter;
+		qstrncpy(ext->extname, qPrintable(QString("out.vol%1").arg(ctrl)), sizeof(ext->extname));
+		return (0);
+	}
+
+case SNDCTL_MIX_READ:
+	{
+		oss_mixer_value *mv = static_cast<oss_mixer_value *>(arg);
+		if (mv->ctrl<1 || mv->ctrl>=m_controls.count()) break;
+
+		++readCalls;
+		mv->value = m_controls[mv->ctrl].value;
+		return (0);
+	}
+
+default:
+		break;
+	}
+
+	errno = EINVAL;
+	return (-1);
+}
+
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+
+	const int numControls = (argc>1 ? atoi(argv[1]) : 64);
+	const int numReads = (argc>2 ? atoi(argv[2]) : 10000);
+	if (numControls<1 || numReads<1)
+	{
+		std::cerr << "Usage: " << argv[0] << " [controls [reads]]" << std::endl;
+		return (1);
+	}
+
+	// The MixDevice's need a Mixer for their ID.  It is not opened,
+	// and its own backend is never used.
+	Mixer *mixer = new Mixer(OSS4_getDriverName(), 0);
+	SimulatedOSS4 backend(mixer, numControls);
+	if (backend.openSimulated()!=0)
+	{
+		std::cerr << "Cannot open the simulated mixer" << std::endl;
+		return (1);
+	}
+	backend.readSet();				// the initial forced read
+
+	std::cout << numControls << " controls, " << numReads << " reads" << std::endl;
+	std::cout << "changed\tns/read\tEXTINFO/read\tREAD/read" << std::endl;
+
+	const QList<int> changedCounts = QList<int>() << 0 << 1 << numControls/4 << numControls;
+	for (int changed : changedCounts)
+	{
+		backend.extInfoCalls = 0;
+		backend.readCalls = 0;
+		qint64 elapsed = 0;
+
+		QElapsedTimer timer;
+		for (int i = 0; i<numReads; ++i)
+		{
+			backend.changeControls(changed);
+			timer.start();
+			backend.readSet();
+			elapsed += timer.nsecsElapsed();
+		}
+
+		std::cout << changed << '\t'
+			  << elapsed/numReads << '\t'
+			  << double(backend.extInfoCalls)/numReads << '\t'
+			  << double(backend.readCalls)/numReads << std::endl;
+	}
+
+	// The Mixer is not deleted, the backend refers to it until it is destroyed
+	return (0);
+}